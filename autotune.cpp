@@ -0,0 +1,195 @@
+// autotune.cpp
+// Host autotuning and persisted tuning cache.
+
+#include "autotune.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#ifdef __APPLE__
+    #include <sys/sysctl.h>
+#endif
+
+namespace autotune {
+
+namespace {
+
+std::string cpuModel() {
+#if defined(_WIN32)
+    const char* id = std::getenv("PROCESSOR_IDENTIFIER");
+    if (id && id[0] != '\0') return id;
+#elif defined(__APPLE__)
+    char buf[256];
+    size_t len = sizeof(buf);
+    if (sysctlbyname("machdep.cpu.brand_string", buf, &len, nullptr, 0) == 0 && len > 0) {
+        return std::string(buf, strnlen(buf, len));
+    }
+#else
+    std::ifstream in("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.rfind("model name", 0) == 0) {
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) break;
+            size_t start = line.find_first_not_of(" \t", colon + 1);
+            if (start == std::string::npos) break;
+            return line.substr(start);
+        }
+    }
+#endif
+    return "unknown";
+}
+
+// Keys are stored one per line with a tab separator; keep them single-line.
+std::string sanitize(const std::string& s) {
+    std::string out = s;
+    for (char& c : out) {
+        if (c == '\t' || c == '\n' || c == '\r') c = ' ';
+    }
+    return out;
+}
+
+} // namespace
+
+std::string hostKey() {
+    int cores = (int)std::thread::hardware_concurrency();
+    return "cpu=" + sanitize(cpuModel()) + "|cores=" + std::to_string(std::max(1, cores));
+}
+
+std::string stageKey(int width, int height, int stageIndex, const std::string& stageSignature) {
+    return hostKey() + "|res=" + std::to_string(width) + "x" + std::to_string(height) +
+           "|stage=" + std::to_string(stageIndex) + "|" + sanitize(stageSignature);
+}
+
+std::string defaultCachePath() {
+    const char* env = std::getenv("EFFECTGENERATOR_TUNE_CACHE");
+    if (env && env[0] != '\0') return env;
+#ifdef _WIN32
+    const char* base = std::getenv("LOCALAPPDATA");
+    if (!base || base[0] == '\0') return "";
+    return std::string(base) + "\\effectgenerator\\tuning.cache";
+#else
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    if (xdg && xdg[0] != '\0') return std::string(xdg) + "/effectgenerator/tuning.cache";
+    const char* home = std::getenv("HOME");
+    if (!home || home[0] == '\0') return "";
+    return std::string(home) + "/.cache/effectgenerator/tuning.cache";
+#endif
+}
+
+bool TuningCache::load() {
+    entries_.clear();
+    if (path_.empty()) return false;
+    std::ifstream in(path_);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t tab = line.rfind('\t');
+        if (tab == std::string::npos) continue;
+        int threads = std::atoi(line.c_str() + tab + 1);
+        if (threads > 0) entries_[line.substr(0, tab)] = threads;
+    }
+    return true;
+}
+
+bool TuningCache::save() const {
+    if (path_.empty()) return false;
+    std::error_code ec;
+    std::filesystem::path p(path_);
+    if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path(), ec);
+
+    // Write to a temporary file first so a concurrent reader never sees a
+    // truncated cache.
+    std::string tmpPath = path_ + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::trunc);
+        if (!out) return false;
+        for (const auto& e : entries_) {
+            out << e.first << '\t' << e.second << '\n';
+        }
+        if (!out) return false;
+    }
+    std::filesystem::rename(tmpPath, path_, ec);
+    return !ec;
+}
+
+int TuningCache::lookup(const std::string& key) const {
+    auto it = entries_.find(key);
+    return it != entries_.end() ? it->second : 0;
+}
+
+void TuningCache::store(const std::string& key, int threads) {
+    entries_[key] = threads;
+}
+
+std::vector<int> threadCandidates() {
+    int hw = std::max(1, (int)std::thread::hardware_concurrency());
+    std::vector<int> out;
+    for (int t = 1; t < hw; t *= 2) out.push_back(t);
+    out.push_back(hw);
+    return out;
+}
+
+int benchmarkWorkerThreads(const std::function<std::unique_ptr<Effect>()>& makeEffect,
+                           int width, int height, int fps, bool hasBackground,
+                           const std::vector<int>& candidates, const ProbeWindow& window) {
+    int bestThreads = 0;
+    double bestSeconds = 0.0;
+    std::vector<uint8_t> frame((size_t)width * height * 3);
+
+    for (int threads : candidates) {
+        std::unique_ptr<Effect> effect = makeEffect();
+        if (!effect) return 0;
+        if (!effect->setWorkerThreads(threads)) return 0;
+        // Same seed for every candidate so each one renders the same frames.
+        effect->setSeed(1);
+        if (!effect->initialize(width, height, fps)) return 0;
+
+        // Untimed warm-up: first-touch allocations, thread start-up, and
+        // simulations that begin empty are not measured.
+        for (int i = 0; i < std::max(1, window.warmupFrames); ++i) {
+            std::fill(frame.begin(), frame.end(), 0);
+            effect->renderFrame(frame, hasBackground, 1.0f);
+            effect->update();
+        }
+
+        // Running mean/variance of per-frame time (Welford).
+        int n = 0;
+        double mean = 0.0;
+        double m2 = 0.0;
+        double total = 0.0;
+        while (n < std::max(1, window.maxFrames)) {
+            auto start = std::chrono::steady_clock::now();
+            std::fill(frame.begin(), frame.end(), 0);
+            effect->renderFrame(frame, hasBackground, 1.0f);
+            effect->update();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            ++n;
+            total += seconds;
+            double delta = seconds - mean;
+            mean += delta / n;
+            m2 += delta * (seconds - mean);
+
+            if (n < std::max(2, window.minFrames)) continue;
+            if (total >= window.maxSeconds) break;
+            double stdError = std::sqrt(m2 / (n - 1) / n);
+            if (mean > 0.0 && stdError / mean <= window.targetError) break;
+        }
+
+        if (bestThreads == 0 || mean < bestSeconds) {
+            bestThreads = threads;
+            bestSeconds = mean;
+        }
+    }
+    return bestThreads;
+}
+
+} // namespace autotune
@@ -0,0 +1,74 @@
+// autotune.h
+// Host autotuning: micro-benchmarks effect worker counts and persists the
+// winners in a per-host tuning cache.
+
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include "effect_generator.h"
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace autotune {
+
+// Identifies the host: CPU model and logical core count.
+std::string hostKey();
+
+// Cache key for one pipeline stage at a given resolution. `stageSignature`
+// should describe the effect and its options (e.g. "flame --preset candle").
+std::string stageKey(int width, int height, int stageIndex, const std::string& stageSignature);
+
+// Default cache path: $EFFECTGENERATOR_TUNE_CACHE, else a file under the
+// user's cache directory. Returns empty if no suitable location is known.
+std::string defaultCachePath();
+
+// Simple text cache: one "<key>\t<threads>" entry per line.
+class TuningCache {
+public:
+    explicit TuningCache(std::string path) : path_(std::move(path)) {}
+
+    bool load();
+    bool save() const;
+
+    // Returns 0 if no entry exists.
+    int lookup(const std::string& key) const;
+    void store(const std::string& key, int threads);
+
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+    std::map<std::string, int> entries_;
+};
+
+// Candidate worker counts for this host: 1, 2, 4, ... up to and including
+// the hardware thread count.
+std::vector<int> threadCandidates();
+
+// How long each candidate is measured. Warm-up frames run untimed so
+// simulations fill in and caches settle; timing then continues frame by
+// frame until the mean per-frame time is known to within `targetError`
+// (standard error over mean), bounded by `minFrames`/`maxFrames` and
+// `maxSeconds` of timed work.
+struct ProbeWindow {
+    int warmupFrames = 8;
+    int minFrames = 8;
+    int maxFrames = 60;
+    double maxSeconds = 2.0;
+    double targetError = 0.02;
+};
+
+// Measure render+update iterations of a freshly created, identically seeded
+// effect for each candidate worker count and return the fastest by mean
+// per-frame time. Returns 0 if the effect does not accept a worker count
+// (see Effect::setWorkerThreads).
+int benchmarkWorkerThreads(const std::function<std::unique_ptr<Effect>()>& makeEffect,
+                           int width, int height, int fps, bool hasBackground,
+                           const std::vector<int>& candidates, const ProbeWindow& window);
+
+} // namespace autotune
+
+#endif // AUTOTUNE_H
@@ -2,6 +2,9 @@
 // Main implementation of the video generator framework
 
 #include "effect_generator.h"
+#include "perf_stats.h"
+#include "metrics.h"
+#include "task_pool.h"
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
@@ -11,11 +14,16 @@
 #include <cctype>
 #include <sstream>
 #include <vector>
-#include <deque>
+#include <functional>
+#include <map>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <chrono>
+#include <csignal>
+#include <ctime>
+#include <iomanip>
 
 #ifdef _WIN32
     #include <io.h>
@@ -23,6 +31,7 @@
 #else
     #include <sys/wait.h>
     #include <fcntl.h>
+    #include <signal.h>
 #endif
 
 #ifdef _WIN32
@@ -282,13 +291,16 @@ VideoGenerator::ProcessPipe VideoGenerator::spawnProcessPipe(const std::vector<s
 #endif
 }
 
-void VideoGenerator::closeProcessPipe(VideoGenerator::ProcessPipe& proc) {
-    if (!proc.stream) return;
+int VideoGenerator::closeProcessPipe(VideoGenerator::ProcessPipe& proc) {
+    if (!proc.stream) return -1;
     fclose(proc.stream);
     proc.stream = nullptr;
+    int exitStatus = -1;
 #ifdef _WIN32
     if (proc.proc.hProcess) {
         WaitForSingleObject(proc.proc.hProcess, INFINITE);
+        DWORD code = 0;
+        if (GetExitCodeProcess(proc.proc.hProcess, &code)) exitStatus = (int)code;
         CloseHandle(proc.proc.hThread);
         CloseHandle(proc.proc.hProcess);
         proc.proc.hProcess = NULL;
@@ -297,10 +309,13 @@ void VideoGenerator::closeProcessPipe(VideoGenerator::ProcessPipe& proc) {
 #else
     if (proc.pid > 0) {
         int status = 0;
-        waitpid(proc.pid, &status, 0);
+        if (waitpid(proc.pid, &status, 0) == proc.pid && WIFEXITED(status)) {
+            exitStatus = WEXITSTATUS(status);
+        }
         proc.pid = -1;
     }
 #endif
+    return exitStatus;
 }
 
 std::string VideoGenerator::findFFmpeg(std::string binaryName) {
@@ -348,6 +363,120 @@ std::string VideoGenerator::findFFmpeg(std::string binaryName) {
     return ""; // Not found
 }
 
+namespace {
+std::atomic<uint64_t> frameBufferCopies(0);
+
+// Lowercase extension of an output file name, without the dot.
+std::string outputExtension(const char* filename) {
+    std::string ext;
+    if (filename) {
+        std::string out(filename);
+        size_t dot = out.find_last_of('.');
+        if (dot != std::string::npos && dot + 1 < out.size()) {
+            ext = out.substr(dot + 1);
+            std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c){ return std::tolower(c); });
+        }
+    }
+    return ext;
+}
+
+// Presets --encoder-speed auto chooses from, fastest first, and the index of
+// the one used by default.
+const std::vector<std::string>& encoderPresets(const std::string& codec, size_t& defaultIndex) {
+    static const std::vector<std::string> x264 = {
+        "ultrafast", "superfast", "veryfast", "faster", "fast", "medium", "slow", "slower"
+    };
+    static const std::vector<std::string> svtav1 = {"12", "11", "10", "9", "8", "7", "6", "5", "4"};
+    defaultIndex = 5;
+    return codec == "libsvtav1" ? svtav1 : x264;
+}
+
+// Every preset `codec` accepts, not only the ones auto calibration tries.
+bool encoderAcceptsPreset(const std::string& codec, const std::string& preset, std::string& accepted) {
+    if (codec == "libsvtav1") {
+        accepted = "0 (slowest) to 13 (fastest)";
+        if (preset.empty() || preset.size() > 2) return false;
+        if (!std::all_of(preset.begin(), preset.end(), [](unsigned char c) { return std::isdigit(c); })) return false;
+        return std::atoi(preset.c_str()) <= 13;
+    }
+    static const std::vector<std::string> x264 = {
+        "ultrafast", "superfast", "veryfast", "faster", "fast", "medium", "slow", "slower", "veryslow", "placebo"
+    };
+    accepted.clear();
+    for (const auto& p : x264) accepted += (accepted.empty() ? "" : ", ") + p;
+    return std::find(x264.begin(), x264.end(), preset) != x264.end();
+}
+
+#ifndef _WIN32
+// Blocks SIGPIPE on the calling thread only, so a write to an encoder that
+// died fails with EPIPE instead of killing the process. A SIGPIPE raised
+// meanwhile is consumed before the previous mask is restored; other threads
+// and the process-wide disposition are untouched.
+class ScopedSigpipeBlock {
+public:
+    ScopedSigpipeBlock() {
+        sigemptyset(&pipeSet_);
+        sigaddset(&pipeSet_, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &pipeSet_, &previous_);
+    }
+
+    ~ScopedSigpipeBlock() {
+        if (sigismember(&previous_, SIGPIPE)) return;
+        sigset_t pending;
+        sigemptyset(&pending);
+        if (sigpending(&pending) == 0 && sigismember(&pending, SIGPIPE)) {
+            int sig = 0;
+            sigwait(&pipeSet_, &sig);
+        }
+        pthread_sigmask(SIG_SETMASK, &previous_, nullptr);
+    }
+
+    ScopedSigpipeBlock(const ScopedSigpipeBlock&) = delete;
+    ScopedSigpipeBlock& operator=(const ScopedSigpipeBlock&) = delete;
+
+private:
+    sigset_t pipeSet_;
+    sigset_t previous_;
+};
+#endif
+}
+
+bool VideoGenerator::checkEncoderSpeed(const std::string& speed, const char* filename) {
+    if (speed.empty() || speed == "auto") return true;
+    std::string codec = presetEncoder(filename);
+    if (codec.empty()) {
+        std::string ext = outputExtension(filename);
+        std::cerr << "Error: --encoder-speed " << speed << " has no effect on ";
+        if (filename && std::strcmp(filename, "-") == 0) std::cerr << "raw video written to stdout";
+        else if (ext == "mov") std::cerr << "MOV (ProRes) output, which has no speed presets";
+        else std::cerr << "output encoded with FFMPEG_PARAMETERS";
+        std::cerr << "; drop the option or use 'auto'\n";
+        return false;
+    }
+    std::string accepted;
+    if (!encoderAcceptsPreset(codec, speed, accepted)) {
+        std::cerr << "Error: Invalid --encoder-speed '" << speed << "' for "
+                  << (codec == "libsvtav1" ? "WebM (SVT-AV1)" : "libx264") << " output. Valid values: auto, "
+                  << accepted << "\n";
+        return false;
+    }
+    return true;
+}
+
+std::vector<uint8_t>& FrameBuffer::write() {
+    if (!data_) {
+        data_ = std::make_shared<std::vector<uint8_t>>();
+    } else if (data_.use_count() > 1) {
+        data_ = std::make_shared<std::vector<uint8_t>>(*data_);
+        frameBufferCopies.fetch_add(1, std::memory_order_relaxed);
+    }
+    return *data_;
+}
+
+uint64_t FrameBuffer::copyCount() {
+    return frameBufferCopies.load(std::memory_order_relaxed);
+}
+
 VideoGenerator::VideoGenerator(int width, int height, int fps, float fadeDuration, float maxFadeRatio, int crf, std::string audioCodec, std::string audioBitrate)
     : width_(width), height_(height), fps_(fps), fadeDuration_(fadeDuration), maxFadeRatio_(maxFadeRatio), crf_(crf), audioCodec_(audioCodec), audioBitrate_(audioBitrate),
       warmupSeconds_(0.0f), hasBackground_(false), isVideo_(false), readRawBackgroundFromStdin_(false), writeRawOutputToStdout_(false) {
@@ -458,12 +587,13 @@ double VideoGenerator::probeVideoDuration(const char* filename) {
     return secs;
 }
 
-bool VideoGenerator::readVideoFrame() {
+bool VideoGenerator::readVideoFrame(std::vector<uint8_t>& buffer) {
     FILE* inputStream = readRawBackgroundFromStdin_ ? stdin : videoInput_.stream;
     if (!inputStream) return false;
 
-    size_t bytesRead = fread(backgroundBuffer_.data(), 1, backgroundBuffer_.size(), inputStream);
-    return bytesRead == backgroundBuffer_.size();
+    buffer.resize((size_t)width_ * height_ * 3);
+    size_t bytesRead = fread(buffer.data(), 1, buffer.size(), inputStream);
+    return bytesRead == buffer.size();
 }
 
 bool VideoGenerator::setBackgroundImage(const char* filename) {
@@ -546,16 +676,9 @@ bool VideoGenerator::startFFmpegOutput(const char* filename) {
         }
         return true;
     } else {
-        // Determine output extension (lowercase)
-        std::string outExt;
-        if (filename) {
-            std::string out(filename);
-            size_t dot = out.find_last_of('.');
-            if (dot != std::string::npos && dot + 1 < out.size()) {
-                outExt = out.substr(dot + 1);
-                std::transform(outExt.begin(), outExt.end(), outExt.begin(), [](unsigned char c){ return std::tolower(c); });
-            }
-        }
+        std::string outExt = outputExtension(filename);
+        std::vector<std::string> threadArgs;
+        if (encoderThreads_ > 0) threadArgs = {"-threads", std::to_string(encoderThreads_)};
 
         // Build Audio parameters if specified
         std::vector<std::string> audioArgs1;
@@ -581,13 +704,12 @@ bool VideoGenerator::startFFmpegOutput(const char* filename) {
                 "-framerate", std::to_string(fps_),
                 "-i", "-",
                 "-c:v", "libsvtav1",
-                "-preset", "7",
+                "-preset", encoderPreset_.empty() ? "7" : encoderPreset_,
                 "-crf", std::to_string(crf_),
-                "-pix_fmt", "yuv420p",
-                filename,
-                "-hide_banner",
-                "-loglevel", "error"
+                "-pix_fmt", "yuv420p"
             };
+            args.insert(args.end(), threadArgs.begin(), threadArgs.end());
+            args.insert(args.end(), {filename, "-hide_banner", "-loglevel", "error"});
             ffmpegOutput_ = spawnProcessPipe(args, "w", true);
         } else if (outExt == "mov") {
             std::vector<std::string> args = {
@@ -620,7 +742,9 @@ bool VideoGenerator::startFFmpegOutput(const char* filename) {
             if (!audioArgs1.empty()) {
                 args.insert(args.end(), audioArgs1.begin(), audioArgs1.end());
             }
-            args.insert(args.end(), {"-c:v", "libx264", "-preset", "medium", "-crf", std::to_string(crf_), "-pix_fmt", "yuv420p"});
+            args.insert(args.end(), {"-c:v", "libx264", "-preset", encoderPreset_.empty() ? "medium" : encoderPreset_,
+                                     "-crf", std::to_string(crf_), "-pix_fmt", "yuv420p"});
+            args.insert(args.end(), threadArgs.begin(), threadArgs.end());
             if (!audioArgs2.empty()) {
                 args.insert(args.end(), audioArgs2.begin(), audioArgs2.end());
             }
@@ -636,6 +760,117 @@ bool VideoGenerator::startFFmpegOutput(const char* filename) {
     return true;
 }
 
+std::string VideoGenerator::presetEncoder(const char* filename) {
+    if (!filename || std::strcmp(filename, "-") == 0) return "";
+    const char* customParams = std::getenv("FFMPEG_PARAMETERS");
+    if (customParams && customParams[0] != '\0') return "";
+    std::string ext = outputExtension(filename);
+    if (ext == "webm") return "libsvtav1";
+    if (ext == "mov") return "";
+    return "libx264";
+}
+
+double VideoGenerator::measureEncodeRate(const std::vector<FrameBuffer>& frames, const std::string& codec,
+                                         const std::string& preset, int threads) {
+    std::vector<std::string> args = {
+        ffmpegPath_,
+        "-y",
+        "-f", "rawvideo",
+        "-pixel_format", "rgb24",
+        "-video_size", std::to_string(width_) + "x" + std::to_string(height_),
+        "-framerate", std::to_string(fps_),
+        "-i", "-",
+        "-c:v", codec,
+        "-preset", preset,
+        "-crf", std::to_string(crf_),
+        "-pix_fmt", "yuv420p"
+    };
+    if (threads > 0) args.insert(args.end(), {"-threads", std::to_string(threads)});
+    args.insert(args.end(), {"-f", "null", "-", "-hide_banner", "-loglevel", "error"});
+
+    auto start = std::chrono::steady_clock::now();
+    ProcessPipe pipe = spawnProcessPipe(args, "w", true);
+    bool ok = pipe.stream != nullptr;
+    int status = 0;
+    {
+#ifndef _WIN32
+        // An encoder that fails to start must not take us down with SIGPIPE.
+        ScopedSigpipeBlock noSigpipe;
+#endif
+        for (size_t i = 0; ok && i < frames.size(); ++i) {
+            const std::vector<uint8_t>& pixels = frames[i].read();
+            ok = fwrite(pixels.data(), 1, pixels.size(), pipe.stream) == pixels.size();
+        }
+        status = closeProcessPipe(pipe);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!ok || status != 0 || seconds <= 0.0) return 0.0;
+    return (double)frames.size() / seconds;
+}
+
+void VideoGenerator::calibrateEncoder(const std::vector<FrameBuffer>& frames, const std::string& codec,
+                                      double renderFps, double renderCores, bool keepPreset, std::ostream& log) {
+    // Leave the encoder the cores rendering doesn't use, so the two don't
+    // oversubscribe the host once they run side by side.
+    const int cores = std::max(1, (int)std::thread::hardware_concurrency());
+    encoderThreads_ = std::max(1, cores - (int)std::lround(renderCores));
+
+    auto oneDecimal = [](double v) {
+        std::ostringstream os;
+        os << std::fixed << std::setprecision(1) << v;
+        return os.str();
+    };
+
+    size_t index = 0;
+    const std::vector<std::string>& presets = encoderPresets(codec, index);
+    log << "Encoder calibration: rendering " << oneDecimal(renderFps) << " frames/s on ~"
+        << oneDecimal(renderCores) << " cores; " << encoderThreads_ << " encoder threads\n";
+    if (keepPreset) {
+        // Segments are joined by stream copy, which needs the same stream
+        // headers in every segment, and presets change them.
+        encoderPreset_ = presets[index];
+        log << "  keeping preset " << encoderPreset_ << " so segments can be joined\n";
+        return;
+    }
+
+    // The slowest (best compressing) preset that still outpaces rendering.
+    const double kHeadroom = 1.15;
+    const int kMaxProbes = 4;
+    const double target = renderFps * kHeadroom;
+    int probes = 0;
+    auto probe = [&](size_t i) {
+        ++probes;
+        double rate = measureEncodeRate(frames, codec, presets[i], encoderThreads_);
+        log << "  preset " << presets[i] << ": " << (rate > 0.0 ? oneDecimal(rate) + " frames/s" : "encoder failed") << "\n";
+        return rate;
+    };
+    double rate = probe(index);
+    if (rate <= 0.0) {
+        log << "  encoder probe failed; using the default preset\n";
+        encoderPreset_.clear();
+        encoderThreads_ = 0;
+        return;
+    }
+    if (rate < target) {
+        while (index > 0 && rate < target && probes < kMaxProbes) {
+            double faster = probe(index - 1);
+            if (faster <= 0.0) break;
+            --index;
+            rate = faster;
+        }
+    } else {
+        while (index + 1 < presets.size() && probes < kMaxProbes) {
+            double slower = probe(index + 1);
+            if (slower < target) break;
+            ++index;
+            rate = slower;
+        }
+    }
+    encoderPreset_ = presets[index];
+    log << "  using preset " << encoderPreset_ << " (" << oneDecimal(rate) << " frames/s)"
+        << (rate < target ? "; the encoder will still limit throughput" : "") << "\n";
+}
+
 float VideoGenerator::getFadeMultiplier(int frameNumber, int totalFrames, float maxFadeRatio) {
     if (fadeDuration_ <= 0.0f) return maxFadeRatio;
     
@@ -649,6 +884,12 @@ float VideoGenerator::getFadeMultiplier(int frameNumber, int totalFrames, float
     return maxFadeRatio;
 }
 
+size_t VideoGenerator::framesInFlight(size_t stages, size_t parallelStages, int frameWorkers, size_t frameBytes) {
+    size_t frames = kStageQueueFrames * stages + 2 * (size_t)std::max(1, frameWorkers) * parallelStages;
+    size_t budgetFrames = std::max(stages + 1, kFrameBudgetBytes / std::max<size_t>(1, frameBytes));
+    return std::min(frames, budgetFrames);
+}
+
 bool VideoGenerator::generate(const std::vector<Effect*>& effects, const std::vector<float>& stageMaxFadeRatios, int durationSec, const char* outputFile) {
     if (effects.empty()) return false;
     if (stageMaxFadeRatios.size() != effects.size()) {
@@ -661,6 +902,12 @@ bool VideoGenerator::generate(const std::vector<Effect*>& effects, const std::ve
             return false;
         }
     }
+    for (const StageWindow& w : stageWindows_) {
+        if (w.startSec < 0.0f || w.rampSec < 0.0f || (w.endSec >= 0.0f && w.endSec <= w.startSec)) {
+            std::cerr << "Error: Stage --start/--end/--ramp must be non-negative with --end after --start\n";
+            return false;
+        }
+    }
 
     const bool outputToStdoutRaw = (outputFile && std::strcmp(outputFile, "-") == 0);
     std::ostream& log = outputToStdoutRaw ? std::cerr : std::cout;
@@ -686,22 +933,48 @@ bool VideoGenerator::generate(const std::vector<Effect*>& effects, const std::ve
     }
     bool autoDetectDuration = (totalFrames == INT_MAX);
 
+    // With a frame range, only a slice of the timeline is rendered; fades
+    // are computed on timeline positions so segments join seamlessly.
+    const int timelineFrames = totalFrames;
+    int timelineOffset = 0;
+    if (rangeCount_ > 0) {
+        if (autoDetectDuration || rangeFirst_ < 0 || rangeFirst_ >= totalFrames) {
+            std::cerr << "Error: Frame range starting at " << rangeFirst_ << " is outside the "
+                      << (autoDetectDuration ? "auto-detected" : std::to_string(totalFrames) + "-frame") << " timeline\n";
+            return false;
+        }
+        timelineOffset = rangeFirst_;
+        totalFrames = std::min(rangeCount_, totalFrames - rangeFirst_);
+        log << "Rendering frames " << rangeFirst_ << "-" << (rangeFirst_ + totalFrames - 1)
+            << " of " << timelineFrames << "\n";
+    }
+
+    // Effects see timeline frame numbers, so a slice behaves like the same
+    // frames of a continuous render.
     for (Effect* effect : effects) {
         if (!effect) return false;
-        if (totalFrames != INT_MAX) {
-            effect->setTotalFrames(totalFrames);
+        if (timelineFrames != INT_MAX) {
+            effect->setTotalFrames(timelineFrames);
         }
         effect->setGlobalWarmupSeconds(std::max(0.0f, warmupSeconds_));
+        if (rangeCount_ > 0 && !effect->supportsFrameRange()) {
+            std::cerr << "Error: The " << effect->getName() << " effect depends on the whole timeline "
+                      << "with these settings and cannot render a frame range\n";
+            return false;
+        }
         if (!effect->initialize(width_, height_, fps_)) {
             std::cerr << "Effect initialization failed\n";
             return false;
         }
     }
 
-    int warmupFrames = (int)std::round(std::max(0.0f, warmupSeconds_) * fps_);
+    const float prerollSeconds = rangeCount_ > 0 ? std::max(0.0f, prerollSeconds_) : 0.0f;
+    int warmupFrames = (int)std::round((std::max(0.0f, warmupSeconds_) + prerollSeconds) * fps_);
     if (warmupFrames > 0) {
         log << "Warmup: advancing simulation by " << warmupFrames
-            << " frames (" << warmupSeconds_ << "s)\n";
+            << " frames (" << warmupSeconds_ << "s";
+        if (prerollSeconds > 0.0f) log << " + " << prerollSeconds << "s before the frame range";
+        log << ")\n";
         for (Effect* effect : effects) {
             for (int i = 0; i < warmupFrames; ++i) {
                 effect->update();
@@ -709,54 +982,42 @@ bool VideoGenerator::generate(const std::vector<Effect*>& effects, const std::ve
         }
     }
 
-    if (!startFFmpegOutput(outputFile)) {
+    // With --encoder-speed auto the writer holds the first rendered frames
+    // back, measures how fast the pipeline renders them, and calibrates the
+    // encoder on them before starting it.
+    encoderPreset_.clear();
+    encoderThreads_ = 0;
+    std::string calibrationCodec;
+    if (encoderSpeed_ == "auto") {
+        calibrationCodec = presetEncoder(outputFile);
+        if (calibrationCodec.empty()) {
+            log << "Note: --encoder-speed auto only applies to libx264 and SVT-AV1 output; using encoder defaults\n";
+        }
+    } else {
+        encoderPreset_ = encoderSpeed_;
+    }
+    // About a second of video, at most ~128 MB of held frames.
+    const size_t frameBytes = (size_t)width_ * height_ * 3;
+    const int calibrationFrames = std::max(8, std::min({fps_, 30, (int)((128u << 20) / std::max<size_t>(1, frameBytes))}));
+    if (!calibrationCodec.empty() && totalFrames < 4 * calibrationFrames) {
+        log << "Note: video too short to calibrate the encoder; using encoder defaults\n";
+        calibrationCodec.clear();
+    }
+    bool encoderStarted = calibrationCodec.empty();
+    if (encoderStarted && !startFFmpegOutput(outputFile)) {
         return false;
     }
 
-    struct FramePacket {
-        std::vector<uint8_t> frame;
-        int frameIndex = 0;
-        bool end = false;
-    };
-
-    class FrameQueue {
-    public:
-        explicit FrameQueue(size_t capacity) : capacity_(capacity) {}
-
-        bool push(FramePacket&& packet) {
-            std::unique_lock<std::mutex> lock(mu_);
-            cvNotFull_.wait(lock, [&]() { return closed_ || queue_.size() < capacity_; });
-            if (closed_) return false;
-            queue_.push_back(std::move(packet));
-            cvNotEmpty_.notify_one();
-            return true;
-        }
-
-        bool pop(FramePacket& out) {
-            std::unique_lock<std::mutex> lock(mu_);
-            cvNotEmpty_.wait(lock, [&]() { return closed_ || !queue_.empty(); });
-            if (queue_.empty()) return false;
-            out = std::move(queue_.front());
-            queue_.pop_front();
-            cvNotFull_.notify_one();
-            return true;
-        }
-
-        void close() {
-            std::lock_guard<std::mutex> lock(mu_);
-            closed_ = true;
-            cvNotEmpty_.notify_all();
-            cvNotFull_.notify_all();
-        }
-
-    private:
-        std::mutex mu_;
-        std::condition_variable cvNotEmpty_;
-        std::condition_variable cvNotFull_;
-        std::deque<FramePacket> queue_;
-        const size_t capacity_;
-        bool closed_ = false;
-    };
+    const int frameWorkers = frameWorkers_ > 0 ? frameWorkers_ : std::max(1, (int)std::thread::hardware_concurrency());
+    // Stages whose effect can hand out a render snapshot render several
+    // frames at once; their update() calls stay sequential.
+    std::vector<bool> stageParallel(effects.size(), false);
+    size_t parallelStages = 0;
+    for (size_t i = 0; i < effects.size() && frameWorkers > 1; ++i) {
+        std::unique_ptr<Effect> snapshot(effects[i]->cloneForRender());
+        stageParallel[i] = snapshot != nullptr;
+        if (stageParallel[i]) ++parallelStages;
+    }
 
     auto computeStageFade = [&](int frameIndex, bool stageHasBackground, float stageMaxFadeRatio) -> float {
         if (!stageHasBackground) return 1.0f;
@@ -766,121 +1027,450 @@ bool VideoGenerator::generate(const std::vector<Effect*>& effects, const std::ve
             if (frameIndex < fadeFrames) return (float)frameIndex * stageMaxFadeRatio / fadeFrames;
             return stageMaxFadeRatio;
         }
-        return getFadeMultiplier(frameIndex, totalFrames, stageMaxFadeRatio);
+        return getFadeMultiplier(timelineOffset + frameIndex, timelineFrames, stageMaxFadeRatio);
     };
 
-    const size_t queueCapacity = 8;
-    std::vector<std::unique_ptr<FrameQueue>> stageQueues;
-    stageQueues.reserve(effects.size());
-    for (size_t i = 0; i < effects.size(); ++i) {
-        stageQueues.push_back(std::make_unique<FrameQueue>(queueCapacity));
+    // Stage windows in timeline frames. A window ramp scales the stage's
+    // fade the same way --fade does at the ends of the video.
+    struct FrameWindow {
+        int first = 0;
+        int last = INT_MAX;  // exclusive
+        int rampFrames = 0;
+    };
+    std::vector<FrameWindow> frameWindows(effects.size());
+    for (size_t i = 0; i < effects.size() && i < stageWindows_.size(); ++i) {
+        const StageWindow& w = stageWindows_[i];
+        frameWindows[i].first = (int)std::round(w.startSec * fps_);
+        if (w.endSec >= 0.0f) frameWindows[i].last = (int)std::round(w.endSec * fps_);
+        frameWindows[i].rampFrames = (int)(w.rampSec * fps_);
+        if (!w.isDefault()) {
+            log << "Stage " << (i + 1) << " (" << effects[i]->getName() << ") active from " << w.startSec << "s";
+            if (w.endSec >= 0.0f) log << " to " << w.endSec << "s";
+            log << "\n";
+        }
     }
+    std::vector<int> bypassedFrames(effects.size(), 0);
+
+    auto windowRamp = [&](const FrameWindow& w, int frameIndex) -> float {
+        int t = timelineOffset + frameIndex;
+        if (t < w.first || t >= w.last) return 0.0f;
+        if (w.rampFrames <= 0) return 1.0f;
+        float ramp = 1.0f;
+        if (t - w.first < w.rampFrames) ramp = (float)(t - w.first) / w.rampFrames;
+        if (w.last != INT_MAX && w.last - t < w.rampFrames) ramp = std::min(ramp, (float)(w.last - t) / w.rampFrames);
+        return ramp;
+    };
 
-    std::atomic<bool> sourceEnded(false);
-    std::atomic<int> sourceFrameCount(0);
-    std::vector<std::thread> workers;
-    workers.reserve(effects.size());
+    const bool readAhead = isVideo_ && hasBackground_;
+    const size_t readAheadFrames = kReadAheadFrames;
+    const int inFlightLimit = (int)framesInFlight(effects.size(), parallelStages, frameWorkers, frameBytes);
+    const int poolThreads = std::max(1, (int)std::thread::hardware_concurrency());
 
-    for (size_t stage = 0; stage < effects.size(); ++stage) {
-        workers.emplace_back([&, stage]() {
-            Effect* effect = effects[stage];
-            const bool stageHasBackground = hasBackground_ || stage > 0;
-            const float stageMaxFadeRatio = stageMaxFadeRatios[stage];
-            FrameQueue* outputQueue = stageQueues[stage].get();
-            FrameQueue* inputQueue = (stage == 0) ? nullptr : stageQueues[stage - 1].get();
+    if (metrics_) {
+        std::vector<std::string> stageNames;
+        for (Effect* effect : effects) stageNames.push_back(effect->getName());
+        metrics_->beginRun(stageNames, totalFrames, (size_t)inFlightLimit, poolThreads);
+    }
 
-            int stageFrameIndex = 0;
-            while (stageFrameIndex < totalFrames) {
-                std::vector<uint8_t> frame(width_ * height_ * 3);
-                int logicalFrame = stageFrameIndex;
+    // One recorder per stage plus one for the writer (this thread).
+    std::vector<std::unique_ptr<perfstats::StageRecorder>> recorders;
+    if (collectStats_) {
+        for (size_t i = 0; i < effects.size(); ++i) {
+            recorders.push_back(std::make_unique<perfstats::StageRecorder>(
+                std::to_string(i + 1) + ":" + effects[i]->getName()));
+        }
+        recorders.push_back(std::make_unique<perfstats::StageRecorder>("writer"));
+    }
 
-                if (stage == 0) {
-                    if (isVideo_ && hasBackground_) {
-                        if (!readVideoFrame()) {
-                            if (autoDetectDuration) {
-                                sourceEnded.store(true);
-                                break;
-                            }
-                        }
-                    }
+    // Every (stage, frame) step is a task on one shared pool. A stage takes
+    // its frames in order, one step at a time, because effects are stateful;
+    // different stages, and the renders of frame-parallel stages, run on
+    // whichever worker is free. Finished frames are kept by frame index, so
+    // out-of-order completion needs no reordering. Dropped frames stay in
+    // the chain as holes that later stages and the writer skip.
+    struct Slot {
+        FrameBuffer frame;
+        bool dropped = false;
+    };
+    struct StageState {
+        int next = 0;              // next frame this stage takes
+        bool busy = false;         // a sequential step is queued or running
+        int rendering = 0;         // frame-parallel renders queued or running
+        int peakRendering = 0;
+        std::map<int, Slot> done;  // finished frames not yet taken downstream
+        size_t doneBytes = 0;      // pixels held in `done`, and its peak
+        size_t peakDoneBytes = 0;
+    };
+    std::mutex schedMu;
+    std::condition_variable schedCv;
+    std::vector<StageState> stageStates(effects.size());
+    std::map<int, FrameBuffer> sourceFrames;  // decoded ahead, not yet taken by stage 0
+    int sourceEnd = totalFrames;              // lowered when an auto-detected input ends
+    bool sourceEnded = false;
+    int consumed = 0;                         // frames taken by the writer, dropped ones included
+    bool aborted = false;                     // output failed: schedule and read nothing more
+    int peakInFlight = 0;
+    size_t heldBytes = 0;                     // pixels waiting in every stage's `done`
+    size_t peakHeldBytes = 0;
+    uint64_t tasks = 0;
+
+    // Stage 0 starts every frame from one shared buffer; the first effect
+    // that writes takes its own copy.
+    const FrameBuffer initialFrame(hasBackground_ ? backgroundBuffer_
+                                                  : std::vector<uint8_t>((size_t)width_ * height_ * 3, 0));
+    const uint64_t copiesAtStart = FrameBuffer::copyCount();
+
+    // Called with schedMu held after anything finishes.
+    std::function<void()> pump;
+    taskpool::TaskPool pool(poolThreads);
+
+    // Called with schedMu held.
+    auto finishFrame = [&](size_t stage, int frameIndex, Slot&& slot) {
+        StageState& st = stageStates[stage];
+        size_t bytes = slot.frame.size();
+        st.done.emplace(frameIndex, std::move(slot));
+        st.doneBytes += bytes;
+        st.peakDoneBytes = std::max(st.peakDoneBytes, st.doneBytes);
+        heldBytes += bytes;
+        peakHeldBytes = std::max(peakHeldBytes, heldBytes);
+        if (metrics_) metrics_->stage(stage).queueDepth.store((int)st.done.size());
+    };
 
-                    if (hasBackground_) {
-                        std::copy(backgroundBuffer_.begin(), backgroundBuffer_.end(), frame.begin());
-                    } else {
-                        std::fill(frame.begin(), frame.end(), 0);
-                    }
-                } else {
-                    FramePacket input;
-                    if (!inputQueue->pop(input)) {
-                        break;
-                    }
-                    if (input.end) {
-                        break;
-                    }
-                    logicalFrame = input.frameIndex;
-                    frame = std::move(input.frame);
-                }
+    // Called with schedMu held; moves a finished frame out of `done`.
+    auto takeDone = [&](size_t stage, std::map<int, Slot>::iterator it) {
+        StageState& st = stageStates[stage];
+        Slot slot = std::move(it->second);
+        st.done.erase(it);
+        st.doneBytes -= slot.frame.size();
+        heldBytes -= slot.frame.size();
+        if (metrics_) metrics_->stage(stage).queueDepth.store((int)st.done.size());
+        return slot;
+    };
 
-                float fadeMultiplier = computeStageFade(logicalFrame, stageHasBackground, stageMaxFadeRatio);
-                effect->renderFrame(frame, stageHasBackground, fadeMultiplier);
+    auto addBusy = [&](size_t stage, std::chrono::steady_clock::time_point start, bool frameDone) {
+        if (!metrics_) return;
+        metrics::StageGauges& gauges = metrics_->stage(stage);
+        gauges.busyNanos.fetch_add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        if (frameDone) gauges.frames.fetch_add(1);
+    };
 
-                bool dropFrame = false;
-                effect->postProcess(frame, logicalFrame, autoDetectDuration ? logicalFrame : totalFrames, dropFrame);
-                effect->update();
+    // Render, postprocess and update one frame of a sequential stage.
+    auto stepTask = [&](size_t stage, int frameIndex, std::shared_ptr<FrameBuffer> frame, float fadeMultiplier) {
+        Effect* effect = effects[stage];
+        perfstats::StageRecorder* stats = collectStats_ ? recorders[stage].get() : nullptr;
+        auto busyStart = std::chrono::steady_clock::now();
+        bool dropFrame = false;
+        {
+            perfstats::PhaseScope scope(stats, perfstats::PhaseRender);
+            effect->renderFrameBuffer(*frame, hasBackground_ || stage > 0, fadeMultiplier);
+        }
+        {
+            perfstats::PhaseScope scope(stats, perfstats::PhasePostProcess);
+            effect->postProcessFrameBuffer(*frame, timelineOffset + frameIndex,
+                                           autoDetectDuration ? frameIndex : timelineFrames, dropFrame);
+        }
+        {
+            perfstats::PhaseScope scope(stats, perfstats::PhaseUpdate);
+            effect->update();
+        }
+        addBusy(stage, busyStart, true);
+
+        Slot out;
+        out.dropped = dropFrame;
+        if (!dropFrame) out.frame = std::move(*frame);
+        std::lock_guard<std::mutex> lock(schedMu);
+        finishFrame(stage, frameIndex, std::move(out));
+        stageStates[stage].busy = false;
+        pump();
+    };
 
-                if (!dropFrame) {
-                    FramePacket out;
-                    out.frame = std::move(frame);
-                    out.frameIndex = logicalFrame;
-                    out.end = false;
-                    if (!outputQueue->push(std::move(out))) {
-                        break;
+    // Render and postprocess one frame of a frame-parallel stage on a snapshot.
+    auto renderTask = [&](size_t stage, int frameIndex, std::shared_ptr<Effect> snapshot,
+                          std::shared_ptr<FrameBuffer> frame, float fadeMultiplier) {
+        perfstats::StageRecorder* stats = collectStats_ ? recorders[stage].get() : nullptr;
+        auto busyStart = std::chrono::steady_clock::now();
+        bool dropFrame = false;
+        {
+            perfstats::PhaseScope scope(stats, perfstats::PhaseRender);
+            snapshot->renderFrameBuffer(*frame, hasBackground_ || stage > 0, fadeMultiplier);
+        }
+        {
+            perfstats::PhaseScope scope(stats, perfstats::PhasePostProcess);
+            snapshot->postProcessFrameBuffer(*frame, timelineOffset + frameIndex,
+                                             autoDetectDuration ? frameIndex : timelineFrames, dropFrame);
+        }
+        addBusy(stage, busyStart, true);
+
+        Slot out;
+        out.dropped = dropFrame;
+        if (!dropFrame) out.frame = std::move(*frame);
+        std::lock_guard<std::mutex> lock(schedMu);
+        finishFrame(stage, frameIndex, std::move(out));
+        --stageStates[stage].rendering;
+        pump();
+    };
+
+    // Snapshot a frame-parallel stage for one frame, queue the render, and
+    // advance the effect.
+    auto snapshotTask = [&](size_t stage, int frameIndex, std::shared_ptr<FrameBuffer> frame, float fadeMultiplier) {
+        Effect* effect = effects[stage];
+        perfstats::StageRecorder* stats = collectStats_ ? recorders[stage].get() : nullptr;
+        auto busyStart = std::chrono::steady_clock::now();
+        std::shared_ptr<Effect> snapshot(effect->cloneForRender());
+        {
+            perfstats::PhaseScope scope(stats, perfstats::PhaseUpdate);
+            effect->update();
+        }
+        addBusy(stage, busyStart, false);
+
+        std::lock_guard<std::mutex> lock(schedMu);
+        ++tasks;
+        pool.submit((int)stage, [&renderTask, stage, frameIndex, snapshot, frame, fadeMultiplier]() {
+            renderTask(stage, frameIndex, snapshot, frame, fadeMultiplier);
+        });
+        stageStates[stage].busy = false;
+        pump();
+    };
+
+    pump = [&]() {
+        for (size_t stage = 0; stage < effects.size() && !aborted; ++stage) {
+            StageState& st = stageStates[stage];
+            while (!st.busy && st.next < sourceEnd) {
+                const int k = st.next;
+                if (stageParallel[stage] && st.rendering >= frameWorkers) break;
+
+                Slot input;
+                if (stage == 0) {
+                    // Bounds the frames held between stage 0 and the writer.
+                    if (k >= consumed + inFlightLimit) break;
+                    if (readAhead) {
+                        auto it = sourceFrames.find(k);
+                        if (it == sourceFrames.end()) break;
+                        input.frame = std::move(it->second);
+                        sourceFrames.erase(it);
+                    } else {
+                        input.frame = initialFrame;
                     }
+                    peakInFlight = std::max(peakInFlight, k + 1 - consumed);
+                } else {
+                    StageState& upstream = stageStates[stage - 1];
+                    auto it = upstream.done.find(k);
+                    if (it == upstream.done.end()) break;
+                    input = takeDone(stage - 1, it);
+                }
+                ++st.next;
+
+                const FrameWindow& window = frameWindows[stage];
+                int timelineFrame = timelineOffset + k;
+                if (input.dropped || timelineFrame < window.first || timelineFrame >= window.last) {
+                    // Outside the window the frame is handed on as-is and the
+                    // effect stays paused (no render, postprocess or update).
+                    if (!input.dropped) ++bypassedFrames[stage];
+                    finishFrame(stage, k, std::move(input));
+                    continue;
                 }
 
-                ++stageFrameIndex;
+                float fadeMultiplier = computeStageFade(k, hasBackground_ || stage > 0, stageMaxFadeRatios[stage])
+                    * windowRamp(window, k);
+                auto frame = std::make_shared<FrameBuffer>(std::move(input.frame));
+                st.busy = true;
+                ++tasks;
+                if (stageParallel[stage]) {
+                    ++st.rendering;
+                    st.peakRendering = std::max(st.peakRendering, st.rendering);
+                    pool.submit((int)stage, [&snapshotTask, stage, k, frame, fadeMultiplier]() {
+                        snapshotTask(stage, k, frame, fadeMultiplier);
+                    });
+                } else {
+                    pool.submit((int)stage, [&stepTask, stage, k, frame, fadeMultiplier]() {
+                        stepTask(stage, k, frame, fadeMultiplier);
+                    });
+                }
             }
+        }
+        schedCv.notify_all();
+    };
 
-            if (stage == 0) {
-                sourceFrameCount.store(stageFrameIndex);
+    // Background video frames are decoded ahead on their own thread so a slow
+    // decoder or input pipe overlaps with rendering instead of stalling stage 0.
+    // Once the input runs dry the last frame is repeated, unless the duration
+    // comes from the input itself, in which case the run ends there.
+    std::thread reader;
+    if (readAhead) {
+        reader = std::thread([&]() {
+            auto readFrame = [&](FrameBuffer& out) {
+                std::vector<uint8_t> pixels;
+                if (!readVideoFrame(pixels)) return false;
+                out = FrameBuffer(std::move(pixels));
+                return true;
+            };
+            // Frames are decoded one ahead of the one being queued, so the
+            // reader only keeps a handle on a queued frame (forcing stage 0
+            // to copy it) when that frame has to be repeated.
+            FrameBuffer next;
+            FrameBuffer repeat(backgroundBuffer_);
+            bool inputEnded = !readFrame(next);
+            for (int i = 0; i < totalFrames; ++i) {
+                FrameBuffer frame;
+                if (!inputEnded) {
+                    frame = std::move(next);
+                    next = FrameBuffer();
+                    if (i + 1 < totalFrames) {
+                        inputEnded = !readFrame(next);
+                        if (inputEnded && !autoDetectDuration) repeat = frame;
+                    }
+                } else if (autoDetectDuration) {
+                    std::lock_guard<std::mutex> lock(schedMu);
+                    sourceEnd = i;
+                    sourceEnded = true;
+                    pump();
+                    return;
+                } else {
+                    frame = repeat;
+                }
+                std::unique_lock<std::mutex> lock(schedMu);
+                schedCv.wait(lock, [&]() { return aborted || sourceFrames.size() < readAheadFrames; });
+                if (aborted) return;
+                sourceFrames.emplace(i, std::move(frame));
+                pump();
             }
-
-            FramePacket endPacket;
-            endPacket.end = true;
-            outputQueue->push(std::move(endPacket));
-            outputQueue->close();
         });
     }
 
+    {
+        std::lock_guard<std::mutex> lock(schedMu);
+        pump();
+    }
+
+    perfstats::StageRecorder* writerStats = collectStats_ ? recorders.back().get() : nullptr;
+
     int writtenFrames = 0;
-    FrameQueue* finalQueue = stageQueues.back().get();
-    while (true) {
-        FramePacket packet;
-        if (!finalQueue->pop(packet)) {
-            break;
+    bool outputOk = true;
+    uint64_t encoderBlockedNanos = 0;
+    auto encoderStart = std::chrono::steady_clock::now();
+    auto writeFrame = [&](const FrameBuffer& frame) {
+        if (!outputOk) return;
+        auto writeStart = std::chrono::steady_clock::now();
+        if (metrics_) metrics_->writeStarted();
+        {
+            perfstats::PhaseScope scope(writerStats, perfstats::PhaseWrite);
+#ifndef _WIN32
+            // An encoder that exits early fails the write instead of
+            // killing the process, so the render stops cleanly.
+            ScopedSigpipeBlock noSigpipe;
+#endif
+            const std::vector<uint8_t>& pixels = frame.read();
+            outputOk = fwrite(pixels.data(), 1, pixels.size(), ffmpegOutput_.stream) == pixels.size();
         }
-        if (packet.end) {
-            break;
+        if (!outputOk) {
+            std::cerr << "\nError: Could not write frame " << writtenFrames << " to the output\n";
+            return;
         }
+        uint64_t nanos = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - writeStart).count();
+        encoderBlockedNanos += nanos;
+        if (metrics_) metrics_->frameWritten(nanos);
+        ++writtenFrames;
+        if (writtenFrames % fps_ == 0) {
+            log << "Progress: " << writtenFrames / fps_ << " seconds\r" << std::flush;
+        }
+    };
+
+    std::vector<FrameBuffer> heldFrames;
+    auto heldStart = std::chrono::steady_clock::now();
+    std::clock_t heldCpuStart = 0;
+    // Start the encoder (after calibrating it on the held frames, if there
+    // are enough) and write out what was held back.
+    auto startHeldEncoder = [&]() {
+        encoderStarted = true;
+        if ((int)heldFrames.size() >= calibrationFrames) {
+            double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - heldStart).count();
+            double cpu = (double)(std::clock() - heldCpuStart) / CLOCKS_PER_SEC;
+            if (wall > 0.0) {
+                // Frame-range renders are segments of a larger job.
+                calibrateEncoder(heldFrames, calibrationCodec, (heldFrames.size() - 1) / wall, cpu / wall,
+                                 rangeCount_ > 0, log);
+            }
+        }
+        outputOk = startFFmpegOutput(outputFile);
+        encoderStart = std::chrono::steady_clock::now();
+        for (const FrameBuffer& frame : heldFrames) writeFrame(frame);
+        heldFrames.clear();
+    };
+
+    StageState& lastStage = stageStates.back();
+    for (int k = 0;; ++k) {
+        Slot slot;
+        {
+            std::unique_lock<std::mutex> lock(schedMu);
+            schedCv.wait(lock, [&]() { return lastStage.done.count(k) > 0 || k >= sourceEnd; });
+            auto it = lastStage.done.find(k);
+            if (it == lastStage.done.end()) break;
+            slot = takeDone(effects.size() - 1, it);
+            consumed = k + 1;
+            pump();
+        }
+        if (slot.dropped) continue;
 
         if (!hasBackground_ && fadeDuration_ > 0.0f && !autoDetectDuration) {
-            float fadeMultiplier = getFadeMultiplier(packet.frameIndex, totalFrames, stageMaxFadeRatios.back());
+            float fadeMultiplier = getFadeMultiplier(timelineOffset + k, timelineFrames, stageMaxFadeRatios.back());
             if (fadeMultiplier < 1.0f) {
-                for (size_t j = 0; j < packet.frame.size(); ++j) {
-                    packet.frame[j] = (uint8_t)(packet.frame[j] * fadeMultiplier);
+                std::vector<uint8_t>& pixels = slot.frame.write();
+                for (size_t j = 0; j < pixels.size(); ++j) {
+                    pixels[j] = (uint8_t)(pixels[j] * fadeMultiplier);
                 }
             }
         }
 
-        fwrite(packet.frame.data(), 1, packet.frame.size(), ffmpegOutput_.stream);
-        ++writtenFrames;
-        if (writtenFrames % fps_ == 0) {
-            log << "Progress: " << writtenFrames / fps_ << " seconds\r" << std::flush;
+        if (!encoderStarted) {
+            // Rates are measured from the first held frame, once the
+            // pipeline is already producing.
+            if (heldFrames.empty()) {
+                heldStart = std::chrono::steady_clock::now();
+                heldCpuStart = std::clock();
+            }
+            heldFrames.push_back(std::move(slot.frame));
+            if ((int)heldFrames.size() >= calibrationFrames) startHeldEncoder();
+        } else {
+            writeFrame(slot.frame);
+        }
+        if (!outputOk) {
+            // Nothing more can be written: stop scheduling frames and let
+            // the tasks already running drain.
+            std::lock_guard<std::mutex> lock(schedMu);
+            aborted = true;
+            schedCv.notify_all();
+            break;
         }
     }
+    if (!encoderStarted) startHeldEncoder();
 
-    for (auto& worker : workers) {
-        if (worker.joinable()) worker.join();
+    pool.wait();
+    if (reader.joinable()) reader.join();
+    if (metrics_) metrics_->endRun();
+
+    for (size_t i = 0; i < effects.size(); ++i) {
+        if (!stageParallel[i]) continue;
+        log << "\nStage " << (i + 1) << " (" << effects[i]->getName() << ") rendered up to "
+            << stageStates[i].peakRendering << " frames at once (--frame-workers " << frameWorkers
+            << "); finished frames waiting downstream peaked at "
+            << (stageStates[i].peakDoneBytes + 512 * 1024) / (1024 * 1024) << " MB";
+    }
+    for (size_t i = 0; i < effects.size(); ++i) {
+        if (bypassedFrames[i] == 0) continue;
+        log << "\nStage " << (i + 1) << " (" << effects[i]->getName() << ") passed "
+            << bypassedFrames[i] << " frames through outside its window";
+    }
+
+    if (!calibrationCodec.empty() && outputOk) {
+        // Writer backpressure: how much of the encoding time the pipeline
+        // spent waiting for the encoder to accept frames.
+        double encodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - encoderStart).count();
+        int blockedPercent = encodeSeconds > 0.0 ? (int)std::lround(100.0 * encoderBlockedNanos / 1e9 / encodeSeconds) : 0;
+        log << "\nEncoder preset " << (encoderPreset_.empty() ? "default" : encoderPreset_) << " with "
+            << (encoderThreads_ > 0 ? std::to_string(encoderThreads_) : "default") << " threads; writer blocked on the encoder "
+            << blockedPercent << "% of the time";
     }
 
     if (writeRawOutputToStdout_) {
@@ -889,13 +1479,28 @@ bool VideoGenerator::generate(const std::vector<Effect*>& effects, const std::ve
     } else {
         closeProcessPipe(ffmpegOutput_);
     }
+    if (!outputOk) {
+        return false;
+    }
 
-    if (sourceEnded.load() && autoDetectDuration) {
-        int endedAt = sourceFrameCount.load();
+    if (sourceEnded && autoDetectDuration) {
+        int endedAt = sourceEnd;
         log << "\nInput video ended at frame " << endedAt
             << " (" << endedAt / fps_ << " seconds)\n";
     }
 
+    if (collectStats_) {
+        std::vector<const perfstats::StageRecorder*> report;
+        for (const auto& r : recorders) report.push_back(r.get());
+        perfstats::printReport(log, report);
+        log << "  frame copies (copy-on-write): " << (FrameBuffer::copyCount() - copiesAtStart)
+            << " for " << writtenFrames << " frames written\n";
+        log << "  scheduler: " << tasks << " tasks on " << pool.size() << " pool threads ("
+            << pool.stolen() << " stolen), peak " << peakInFlight << " of " << inFlightLimit
+            << " frames in flight, " << (peakHeldBytes + 512 * 1024) / (1024 * 1024) << " MB of finished frames held"
+            << " (budget " << (kFrameBudgetBytes >> 20) << " MB)\n";
+    }
+
     if (writeRawOutputToStdout_) {
         std::cerr << "\nVideo stream written to stdout\n";
     } else {
@@ -904,6 +1509,61 @@ bool VideoGenerator::generate(const std::vector<Effect*>& effects, const std::ve
     return true;
 }
 
+bool VideoGenerator::concatenate(const std::vector<std::string>& inputFiles, const char* outputFile) {
+    if (inputFiles.empty() || !outputFile) return false;
+    if (ffmpegPath_.empty()) {
+        std::cerr << "Error: FFmpeg not found; cannot concatenate segments\n";
+        return false;
+    }
+
+    // ffmpeg's concat demuxer reads a list file; quote paths for it.
+    std::string listPath = std::string(outputFile) + ".concat.txt";
+    {
+        FILE* list = std::fopen(listPath.c_str(), "w");
+        if (!list) {
+            std::cerr << "Error: Could not write " << listPath << "\n";
+            return false;
+        }
+        for (const auto& input : inputFiles) {
+            std::string quoted;
+            for (char c : input) {
+                if (c == '\'') quoted += "'\\''";
+                else quoted += c;
+            }
+            std::fprintf(list, "file '%s'\n", quoted.c_str());
+        }
+        std::fclose(list);
+    }
+
+    std::vector<std::string> args = {
+        ffmpegPath_,
+        "-y",
+        "-hide_banner",
+        "-loglevel", "error",
+        "-f", "concat",
+        "-safe", "0",
+        "-i", listPath,
+        "-c", "copy",
+        outputFile
+    };
+    ProcessPipe pipe = spawnProcessPipe(args, "r", false);
+    if (!pipe.stream) {
+        std::remove(listPath.c_str());
+        std::cerr << "Error: Could not start FFmpeg for concatenation\n";
+        return false;
+    }
+    char buf[256];
+    while (fgets(buf, sizeof(buf), pipe.stream)) {
+    }
+    int status = closeProcessPipe(pipe);
+    std::remove(listPath.c_str());
+    if (status != 0) {
+        std::cerr << "Error: FFmpeg concatenation failed (exit status " << status << ")\n";
+        return false;
+    }
+    return true;
+}
+
 bool VideoGenerator::generate(const std::vector<Effect*>& effects, int durationSec, const char* outputFile) {
     std::vector<float> stageMaxFadeRatios;
     stageMaxFadeRatios.assign(effects.size(), maxFadeRatio_);
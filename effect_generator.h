@@ -36,6 +36,27 @@ inline const char* getEffectGeneratorVersion() {
     #define PATH_SEPARATOR "/"
 #endif
 
+// Reference-counted RGB24 frame with copy-on-write semantics. Copies of a
+// FrameBuffer share pixels until one of them calls write(), which takes a
+// private copy only if the pixels are still shared.
+class FrameBuffer {
+public:
+    FrameBuffer() = default;
+    explicit FrameBuffer(std::vector<uint8_t> pixels)
+        : data_(std::make_shared<std::vector<uint8_t>>(std::move(pixels))) {}
+
+    bool empty() const { return !data_; }
+    size_t size() const { return data_ ? data_->size() : 0; }
+    const std::vector<uint8_t>& read() const { return *data_; }
+    std::vector<uint8_t>& write();
+
+    // Number of copy-on-write detaches since startup (for --stats).
+    static uint64_t copyCount();
+
+private:
+    std::shared_ptr<std::vector<uint8_t>> data_;
+};
+
 // Base class for all effects
 class Effect {
 public:
@@ -91,12 +112,33 @@ public:
         dropFrame = false;
     }
 
+    // Pipeline entry points. The defaults take a private copy of shared
+    // pixels and call renderFrame/postProcess; effects that only read the
+    // frame, or replace it wholesale, can override these to avoid the copy.
+    virtual void renderFrameBuffer(FrameBuffer& frame, bool hasBackground, float fadeMultiplier) {
+        renderFrame(frame.write(), hasBackground, fadeMultiplier);
+    }
+
+    virtual void postProcessFrameBuffer(FrameBuffer& frame, int frameIndex, int totalFrames, bool& dropFrame) {
+        postProcess(frame.write(), frameIndex, totalFrames, dropFrame);
+    }
+
     // Optional hook: informs the effect what the total frame count will be
     // (useful for effects that need to align behavior to the overall length).
+    // With --frame-range this is the length of the whole timeline, and
+    // postProcess() gets timeline frame indices.
     virtual void setTotalFrames(int /*totalFrames*/) {
         // Default: do nothing
     }
 
+    // Optional hook: return false if a --frame-range slice rendered on its
+    // own cannot match the same frames of a continuous render, e.g. because
+    // the effect loops the end of the timeline back onto its start. Called
+    // after setGlobalWarmupSeconds().
+    virtual bool supportsFrameRange() const {
+        return true;
+    }
+
     // Optional hook: informs effect about global pre-render warmup seconds.
     // Effects that have their own warmup mechanism can use this to avoid
     // applying warmup twice.
@@ -104,6 +146,42 @@ public:
         // Default: do nothing
     }
 
+    // Optional hook: reseed the effect's random generator so a run can be
+    // reproduced (used by --seed and segment rendering). Called before
+    // initialize().
+    virtual void setSeed(uint32_t /*seed*/) {
+        // Default: effect has no randomness
+    }
+
+    // Optional hook: return a copy of the current state that can render the
+    // current frame on another thread while this instance advances with
+    // update(). Only effects whose renderFrame/postProcess don't depend on or
+    // mutate state carried between frames should implement it.
+    virtual std::unique_ptr<Effect> cloneForRender() const {
+        return nullptr;
+    }
+
+    // Optional hook: worker thread count for effects with internal
+    // parallelism, chosen by --autotune or the tuning cache. Return false if
+    // the effect has no internal workers or the user pinned a count.
+    virtual bool setWorkerThreads(int /*threads*/) {
+        return false;
+    }
+
+    // Optional hook: cost model for --estimate. Describes per-frame work on
+    // top of the fixed per-pixel cost in effect-specific units (sparks,
+    // solver cells, ...): `current` for the frame about to be rendered and
+    // `steady` once the simulation has settled. Probes measure the time per
+    // unit, so only the proportions matter.
+    struct CostModel {
+        std::string unit;
+        double current = 0.0;
+        double steady = 0.0;
+    };
+    virtual CostModel costModel() const {
+        return {};
+    }
+
     // Optional: print resolved effect configuration after parsing and
     // initialization/clamping (used by --show mode).
     virtual void printConfig(std::ostream& os) const {
@@ -165,6 +243,18 @@ private:
         static EffectClass##Registrar global_##EffectClass##Registrar; \
     }
 
+namespace metrics { class PipelineMetrics; }
+
+// Part of the --duration timeline during which a stage is applied. Outside
+// it the stage forwards frames untouched and its simulation is paused.
+struct StageWindow {
+    float startSec = 0.0f;
+    float endSec = -1.0f;   // < 0: until the end of the video
+    float rampSec = 0.0f;   // fade the stage in/out over this long at each edge
+
+    bool isDefault() const { return startSec <= 0.0f && endSec < 0.0f; }
+};
+
 // Video generator class
 class VideoGenerator {
 private:
@@ -178,6 +268,16 @@ private:
     std::string audioCodec_;
     std::string audioBitrate_;
     float warmupSeconds_;
+    bool collectStats_ = false;
+    metrics::PipelineMetrics* metrics_ = nullptr;
+    int rangeFirst_ = 0;
+    int rangeCount_ = -1;
+    float prerollSeconds_ = 0.0f;
+    int frameWorkers_ = 0;
+    std::vector<StageWindow> stageWindows_;
+    std::string encoderSpeed_;    // "", "auto" or a preset name
+    std::string encoderPreset_;   // preset for this run; empty = codec default
+    int encoderThreads_ = 0;      // 0 = ffmpeg default
     
     std::vector<uint8_t> frame_;
     std::vector<uint8_t> backgroundBuffer_;
@@ -197,30 +297,83 @@ private:
     ProcessPipe ffmpegOutput_;
 
     static ProcessPipe spawnProcessPipe(const std::vector<std::string>& args, const char* mode, bool quiet, bool captureStderr = false);
-    static void closeProcessPipe(ProcessPipe& proc);
+    // Returns the process exit status (0 on success, -1 if unknown).
+    static int closeProcessPipe(ProcessPipe& proc);
     
     std::string findFFmpeg(std::string binaryName);
     bool loadBackgroundImage(const char* filename);
     bool startBackgroundVideo(const char* filename);
-    bool readVideoFrame();
+    bool readVideoFrame(std::vector<uint8_t>& buffer);
     bool startFFmpegOutput(const char* filename);
+    // Encode `frames` to ffmpeg's null muxer; frames per second, 0 on failure.
+    double measureEncodeRate(const std::vector<FrameBuffer>& frames, const std::string& codec,
+                             const std::string& preset, int threads);
+    // Pick encoderPreset_ and encoderThreads_ so encoding keeps pace with
+    // rendering without taking the cores the render pipeline uses.
+    void calibrateEncoder(const std::vector<FrameBuffer>& frames, const std::string& codec,
+                          double renderFps, double renderCores, bool keepPreset, std::ostream& log);
     // Probe the duration (in seconds) of a video file using ffmpeg
     double probeVideoDuration(const char* filename);
     float getFadeMultiplier(int frameNumber, int totalFrames, float maxFadeRatio);
     
 public:
+    // Frames in flight per stage between stage 0 and the writer, and frames
+    // decoded ahead of stage 0 when reading a background video.
+    static constexpr size_t kStageQueueFrames = 8;
+    static constexpr size_t kReadAheadFrames = 4;
+    // Memory the frames in flight may use, so large frames get a shorter
+    // window than the frame counts above allow.
+    static constexpr size_t kFrameBudgetBytes = size_t(1) << 30;
+    // Most frames the pipeline holds between stage 0 taking a frame and the
+    // writer taking it; frame-parallel stages get room for 2x their workers.
+    // Capped to kFrameBudgetBytes of `frameBytes` frames, but never below one
+    // frame per stage plus one, so every stage can still work concurrently.
+    static size_t framesInFlight(size_t stages, size_t parallelStages, int frameWorkers, size_t frameBytes);
+    // Encoder whose speed --encoder-speed controls for `filename` (libx264 or
+    // libsvtav1), or "" for ProRes, raw stdout and FFMPEG_PARAMETERS output.
+    static std::string presetEncoder(const char* filename);
+    // Check an --encoder-speed value against the encoder `filename` selects,
+    // before anything renders. Prints the problem and returns false for a
+    // preset that encoder does not accept, or for an explicit preset on
+    // output that has no presets. 'auto' always passes; it falls back to
+    // encoder defaults where it cannot apply.
+    static bool checkEncoderSpeed(const std::string& speed, const char* filename);
+
     VideoGenerator(int width, int height, int fps, float fadeDuration, float maxFadeRatio, int crf = 23, std::string audioCodec = "", std::string audioBitrate = "");
     ~VideoGenerator();
     
     void setFFmpegPath(const std::string& path) { ffmpegPath_ = path; }
     void setCRF(int crf) { crf_ = crf; }
     void setWarmupSeconds(float seconds) { warmupSeconds_ = seconds; }
+    // Report per-stage timings and hardware counters after generation.
+    void setCollectStats(bool enabled) { collectStats_ = enabled; }
+    // Publish live progress to `metrics` (owned by the caller) while generating.
+    void setMetrics(metrics::PipelineMetrics* metrics) { metrics_ = metrics; }
+    // Render only `count` frames starting at `first` on the --duration
+    // timeline. Fades are still computed against the full timeline.
+    void setFrameRange(int first, int count) { rangeFirst_ = first; rangeCount_ = count; }
+    // Extra simulation time run before a frame range, on top of the warmup,
+    // so a slice starting from a fresh simulation reaches a steady state.
+    // Effects are not told about it (see Effect::setGlobalWarmupSeconds).
+    void setPrerollSeconds(float seconds) { prerollSeconds_ = seconds; }
+    // Frames rendered concurrently in stages that support it (see
+    // Effect::cloneForRender). 0 = hardware threads, 1 = off.
+    void setFrameWorkers(int workers) { frameWorkers_ = workers; }
+    // Encoder preset for libx264/SVT-AV1 output, or "auto" to calibrate the
+    // preset and encoder threads on the first rendered frames.
+    void setEncoderSpeed(const std::string& speed) { encoderSpeed_ = speed; }
+    // Active window per stage, in pipeline order; stages without an entry
+    // are active for the whole timeline.
+    void setStageWindows(const std::vector<StageWindow>& windows) { stageWindows_ = windows; }
     bool setBackgroundImage(const char* filename);
     bool setBackgroundVideo(const char* filename);
     
     bool generate(const std::vector<Effect*>& effects, const std::vector<float>& stageMaxFadeRatios, int durationSec, const char* outputFile);
     bool generate(const std::vector<Effect*>& effects, int durationSec, const char* outputFile);
     bool generate(Effect* effect, int durationSec, const char* outputFile);
+
+    // Join already encoded files into outputFile without re-encoding.
+    bool concatenate(const std::vector<std::string>& inputFiles, const char* outputFile);
 };
 
 #endif // EFFECT_GENERATOR_H
@@ -0,0 +1,262 @@
+// estimate.cpp
+// Render cost estimation for --estimate.
+
+#include "estimate.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+namespace estimate {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Stand-in for a background: a soft gradient with scattered bright points,
+// so effects that analyse the background (e.g. twinkle's hotspot tracking)
+// do representative work.
+std::vector<uint8_t> syntheticBackground(int width, int height) {
+    std::vector<uint8_t> frame((size_t)width * height * 3);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            size_t idx = ((size_t)y * width + x) * 3;
+            uint8_t v = (uint8_t)(40 + 80 * x / std::max(1, width) + 40 * y / std::max(1, height));
+            frame[idx] = v;
+            frame[idx + 1] = v;
+            frame[idx + 2] = v;
+        }
+    }
+    // 3x3 highlights on a jittered 32-pixel grid.
+    for (int gy = 0; gy < height; gy += 32) {
+        for (int gx = 0; gx < width; gx += 32) {
+            int cx = gx + 4 + (gx * 7 + gy * 13) % 24;
+            int cy = gy + 4 + (gx * 11 + gy * 5) % 24;
+            for (int y = cy - 1; y <= cy + 1; ++y) {
+                for (int x = cx - 1; x <= cx + 1; ++x) {
+                    if (x < 0 || y < 0 || x >= width || y >= height) continue;
+                    size_t idx = ((size_t)y * width + x) * 3;
+                    frame[idx] = frame[idx + 1] = frame[idx + 2] = 255;
+                }
+            }
+        }
+    }
+    return frame;
+}
+
+std::string formatDuration(double seconds) {
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(1);
+    if (seconds < 120.0) {
+        os << seconds << " s";
+    } else if (seconds < 7200.0) {
+        os << seconds / 60.0 << " min";
+    } else {
+        os << seconds / 3600.0 << " h";
+    }
+    return os.str();
+}
+
+} // namespace
+
+StageCost probeStage(Effect& effect, int width, int height, int fps, bool hasBackground, int totalFrames) {
+    const int kSamples = 8;
+    const int kMinSamples = 3;
+    const double kBudgetSeconds = 3.0;
+    // Half a second of simulation between samples, so particle counts and
+    // similar state have time to change.
+    const int stride = std::max(1, fps / 2);
+
+    StageCost cost;
+    cost.name = effect.getName();
+
+    // Probe through the FrameBuffer hooks generate() calls, with the input
+    // shared the way the reader shares it, so copy-on-write costs (or their
+    // absence, for effects that override the hooks) are measured too.
+    const FrameBuffer background(hasBackground
+        ? syntheticBackground(width, height)
+        : std::vector<uint8_t>((size_t)width * height * 3, 0));
+    FrameBuffer frame = background;
+
+    // One untimed frame so first-touch allocations are not measured.
+    bool dropFrame = false;
+    effect.renderFrameBuffer(frame, hasBackground, 1.0f);
+    effect.postProcessFrameBuffer(frame, 0, totalFrames, dropFrame);
+    effect.update();
+
+    std::vector<double> units;
+    std::vector<double> times;
+    double updateSeconds = 0.0;
+    int updates = 0;
+    int simFrame = 1;
+    auto probeStart = Clock::now();
+    for (int i = 0; i < kSamples; ++i) {
+        if (i >= kMinSamples && secondsSince(probeStart) > kBudgetSeconds) break;
+
+        units.push_back(effect.costModel().current);
+        frame = background;
+        auto renderStart = Clock::now();
+        effect.renderFrameBuffer(frame, hasBackground, 1.0f);
+        effect.postProcessFrameBuffer(frame, simFrame, totalFrames, dropFrame);
+        times.push_back(secondsSince(renderStart));
+
+        auto updateStart = Clock::now();
+        for (int s = 0; s < stride; ++s) {
+            effect.update();
+        }
+        updateSeconds += secondsSince(updateStart);
+        updates += stride;
+        simFrame += stride;
+    }
+
+    Effect::CostModel model = effect.costModel();
+    cost.unit = model.unit;
+    cost.steadyUnits = model.steady;
+    cost.probedFrames = (int)times.size();
+    cost.updateSeconds = updateSeconds / std::max(1, updates);
+
+    // Least-squares fit of time = fixed + perUnit * units.
+    double n = (double)times.size();
+    double meanU = 0.0, meanT = 0.0;
+    for (size_t i = 0; i < times.size(); ++i) {
+        meanU += units[i];
+        meanT += times[i];
+    }
+    meanU /= n;
+    meanT /= n;
+    double covUT = 0.0, varU = 0.0;
+    for (size_t i = 0; i < times.size(); ++i) {
+        covUT += (units[i] - meanU) * (times[i] - meanT);
+        varU += (units[i] - meanU) * (units[i] - meanU);
+    }
+    cost.probedUnits = meanU;
+
+    double fixed = meanT;
+    double perUnit = 0.0;
+    if (varU > 1e-9 * std::max(1.0, meanU * meanU) && covUT > 0.0) {
+        perUnit = covUT / varU;
+        fixed = meanT - perUnit * meanU;
+        if (fixed < 0.0) {
+            // Noise put the intercept below zero; treat the cost as all variable.
+            fixed = 0.0;
+            perUnit = meanU > 0.0 ? meanT / meanU : 0.0;
+        }
+    }
+    double maxU = units.empty() ? 0.0 : *std::max_element(units.begin(), units.end());
+    if (model.unit.empty()) {
+        cost.renderSeconds = meanT;
+    } else {
+        cost.renderSeconds = fixed + perUnit * model.steady;
+        cost.extrapolated = model.steady > 2.0 * maxU || (perUnit == 0.0 && std::fabs(model.steady - meanU) > 0.5 * meanU);
+    }
+    return cost;
+}
+
+Prediction predict(const std::vector<StageCost>& stages, const PipelineShape& shape,
+                   long long baseBytes, long long effectBytes) {
+    Prediction p;
+    const int cores = std::max(1, (int)std::thread::hardware_concurrency());
+
+    // Stages run concurrently on the shared pool, each one frame at a time,
+    // so the slowest stage sets the pace unless the stages together need
+    // more CPU than the host has.
+    double slowest = 0.0;
+    double cpuTotal = 0.0;
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const StageCost& s = stages[i];
+        double active = i < shape.activeFraction.size() ? shape.activeFraction[i] : 1.0;
+        bool parallel = i < shape.frameParallel.size() && shape.frameParallel[i];
+        int renderers = parallel ? std::max(1, std::min(shape.frameWorkers, cores)) : 1;
+        double wall = active * (s.renderSeconds / renderers + s.updateSeconds);
+        double cpu = active * (s.renderSeconds + s.updateSeconds);
+        cpuTotal += cpu;
+        if (wall > slowest) {
+            slowest = wall;
+            p.bottleneckStage = (int)i;
+        }
+        p.warmupSeconds += shape.warmupFrames * s.updateSeconds;
+    }
+    p.frameSeconds = slowest;
+    if (cpuTotal / cores > slowest) {
+        p.frameSeconds = cpuTotal / cores;
+        p.bottleneckStage = -1;
+    }
+    p.framesPerSecond = p.frameSeconds > 0.0 ? 1.0 / p.frameSeconds : 0.0;
+    if (shape.frames >= 0) {
+        p.totalSeconds = p.warmupSeconds + shape.frames * p.frameSeconds;
+    }
+
+    if (baseBytes >= 0 && effectBytes >= 0) {
+        // Frames in flight: the scheduler's window from stage 0 to the
+        // writer, the frame the writer holds, and the read-ahead queue.
+        long long frameBytes = (long long)shape.width * shape.height * 3;
+        size_t parallelStages = 0;
+        for (size_t i = 0; i < stages.size(); ++i) {
+            if (i < shape.frameParallel.size() && shape.frameParallel[i]) ++parallelStages;
+        }
+        long long frames = (long long)VideoGenerator::framesInFlight(stages.size(), parallelStages, shape.frameWorkers,
+                                                                       (size_t)frameBytes) + 1;
+        if (shape.readAhead) frames += VideoGenerator::kReadAheadFrames + 1;
+        p.peakBytes = baseBytes + effectBytes + frames * frameBytes;
+    }
+    return p;
+}
+
+void printReport(std::ostream& out, const std::vector<StageCost>& stages,
+                 const PipelineShape& shape, const Prediction& prediction) {
+    // Formatted locally so the caller's stream keeps its own flags and precision.
+    std::ostringstream os;
+    const int cores = std::max(1, (int)std::thread::hardware_concurrency());
+    os << "Estimate for " << shape.width << "x" << shape.height << " @ " << shape.fps << " fps";
+    if (shape.frames >= 0) os << ", " << shape.frames << " frames";
+    os << " on " << cores << " hardware threads (" << shape.frameWorkers << " frame workers)\n\n";
+
+    os << std::fixed;
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const StageCost& s = stages[i];
+        os << "  Stage " << (i + 1) << " (" << s.name << "): " << std::setprecision(2)
+           << s.renderSeconds * 1000.0 << " ms render, " << s.updateSeconds * 1000.0 << " ms update per frame";
+        if (i < shape.frameParallel.size() && shape.frameParallel[i]) os << ", frame-parallel";
+        if (i < shape.activeFraction.size() && shape.activeFraction[i] < 1.0) {
+            os << ", active " << std::setprecision(0) << shape.activeFraction[i] * 100.0 << "% of frames";
+        }
+        os << "\n";
+        if (!s.unit.empty()) {
+            os << "    cost model: " << std::setprecision(0) << s.steadyUnits << " " << s.unit
+               << " per frame when settled (probes saw " << s.probedUnits << " over "
+               << s.probedFrames << " frames" << (s.extrapolated ? "; extrapolated" : "") << ")\n";
+        }
+    }
+
+    os << "\n  Predicted throughput: " << std::setprecision(1) << prediction.framesPerSecond << " frames/s";
+    if (prediction.bottleneckStage >= 0) {
+        os << " (bottleneck: stage " << (prediction.bottleneckStage + 1) << ", "
+           << stages[(size_t)prediction.bottleneckStage].name << ")\n";
+    } else {
+        os << " (bottleneck: CPU; stages together need more than " << cores << " hardware threads)\n";
+    }
+    if (prediction.warmupSeconds > 0.0) {
+        os << "  Warmup: " << formatDuration(prediction.warmupSeconds) << "\n";
+    }
+    if (prediction.totalSeconds >= 0.0) {
+        os << "  Total wall time: " << formatDuration(prediction.totalSeconds) << "\n";
+    } else {
+        os << "  Total wall time: unknown (duration is auto-detected; "
+           << formatDuration(prediction.frameSeconds * shape.fps * 60.0) << " per minute of video)\n";
+    }
+    if (prediction.peakBytes >= 0) {
+        os << "  Peak memory: " << std::setprecision(0) << prediction.peakBytes / (1024.0 * 1024.0) << " MB\n";
+    } else {
+        os << "  Peak memory: unknown on this platform\n";
+    }
+    os << "  (ffmpeg decode/encode time is not included)\n";
+    out << os.str();
+}
+
+} // namespace estimate
@@ -0,0 +1,66 @@
+// estimate.h
+// Render cost estimation for --estimate: short on-host probes calibrate
+// each effect's cost model, then a pipeline model predicts throughput, wall
+// time and peak memory without rendering the video.
+
+#ifndef ESTIMATE_H
+#define ESTIMATE_H
+
+#include "effect_generator.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace estimate {
+
+// Calibrated per-frame cost of one pipeline stage.
+struct StageCost {
+    std::string name;
+    std::string unit;            // cost model unit; empty if the effect has none
+    double probedUnits = 0.0;    // mean work per probed frame
+    double steadyUnits = 0.0;    // expected work per frame once settled
+    double renderSeconds = 0.0;  // predicted render + postprocess per frame
+    double updateSeconds = 0.0;  // per update() call
+    int probedFrames = 0;
+    // Steady-state work lies well outside what the probes rendered, so the
+    // prediction relies on the fitted time per unit.
+    bool extrapolated = false;
+};
+
+// Render a few frames of an initialized effect spread over several seconds
+// of simulation (stepping update() in between) and fit render time against
+// the effect's cost model. Takes a few seconds at most.
+StageCost probeStage(Effect& effect, int width, int height, int fps, bool hasBackground, int totalFrames);
+
+struct PipelineShape {
+    int width = 0;
+    int height = 0;
+    int fps = 0;
+    long long frames = -1;               // -1 if the duration is auto-detected
+    int warmupFrames = 0;
+    int frameWorkers = 1;
+    bool readAhead = false;              // background video decoded ahead
+    std::vector<double> activeFraction;  // per stage, from --start/--end
+    std::vector<bool> frameParallel;     // per stage, see Effect::cloneForRender
+};
+
+struct Prediction {
+    double frameSeconds = 0.0;
+    double framesPerSecond = 0.0;
+    double warmupSeconds = 0.0;
+    double totalSeconds = -1.0;          // -1 if the frame count is unknown
+    int bottleneckStage = -1;            // -1: stages together saturate the cores
+    long long peakBytes = -1;            // -1 if memory can't be measured here
+};
+
+// `baseBytes` is the resident size before the effects were initialized and
+// `effectBytes` what initializing and probing them added (either may be -1).
+Prediction predict(const std::vector<StageCost>& stages, const PipelineShape& shape,
+                   long long baseBytes, long long effectBytes);
+
+void printReport(std::ostream& os, const std::vector<StageCost>& stages,
+                 const PipelineShape& shape, const Prediction& prediction);
+
+} // namespace estimate
+
+#endif // ESTIMATE_H
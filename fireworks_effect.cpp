@@ -54,6 +54,13 @@ private:
     float groundFireSpread_;        // radians, e.g. PI/3
     float groundR_, groundG_, groundB_;
 
+    // Per-update life loss ranges for burst and ground-fire sparks (also
+    // used by costModel to predict how long sparks stay alive).
+    static constexpr float kBurstDecayMin = 0.008f;
+    static constexpr float kBurstDecayMax = 0.02f;
+    static constexpr float kGroundDecayMin = 0.015f;
+    static constexpr float kGroundDecayMax = 0.03f;
+
     std::vector<float> trailBuffer_; // RGB, float, size = width * height * 3
     float trailDecay_;               // e.g. 0.92–0.98
     float trailHalfLifeSec_ = 0.05f; // tweak 0.08–0.18
@@ -132,7 +139,7 @@ private:
         float speedVariation = std::uniform_real_distribution<float>(0.02f, 0.9f)(rng_);
 
         std::uniform_real_distribution<float> distSpeed(1.4f - speedVariation, 1.4f + speedVariation);
-        std::uniform_real_distribution<float> distDecay(0.008f, 0.02f);
+        std::uniform_real_distribution<float> distDecay(kBurstDecayMin, kBurstDecayMax);
         std::uniform_real_distribution<float> distSize(0.5f, 1.5f);
         
         // Randomize number of sparks for this explosion
@@ -179,7 +186,7 @@ private:
             groundFireSpread_ * 0.5f
         );
         std::uniform_real_distribution<float> distSpeed(1.0f, 4.0f);
-        std::uniform_real_distribution<float> distDecay(0.015f, 0.03f);
+        std::uniform_real_distribution<float> distDecay(kGroundDecayMin, kGroundDecayMax);
         std::uniform_real_distribution<float> distSize(0.4f, 1.2f);
 
         float baseX = distX(rng_);
@@ -610,6 +617,36 @@ public:
     }
 
     
+    // Mean updates a spark survives when its decay is uniform in [lo, hi]
+    // and each update removes decay * timeScale_ of its life.
+    double meanSparkUpdates(float lo, float hi) const {
+        return std::log((double)hi / lo) / ((double)hi - lo) / timeScale_;
+    }
+
+    // Splatting live sparks dominates. Steady state is bursts per update
+    // times sparks per burst times updates each spark lives. update() starts
+    // at most one burst of each kind per call.
+    CostModel costModel() const override {
+        CostModel model;
+        model.unit = "sparks";
+        for (const auto& spark : sparks_) {
+            if (spark.active) model.current += 1.0;
+        }
+        double launchesPerUpdate = std::min(1.0, (double)launchFrequency_ * timeScale_ / fps_);
+        double rocketSparks = launchesPerUpdate * sparksPerRocket_ * meanSparkUpdates(kBurstDecayMin, kBurstDecayMax);
+        double groundSparks = 0.0;
+        if (groundFireEnabled_) {
+            double burstsPerUpdate = std::min(1.0, (double)groundFireRate_ * timeScale_ / fps_);
+            groundSparks = burstsPerUpdate * groundFireSparks_ * meanSparkUpdates(kGroundDecayMin, kGroundDecayMax);
+        }
+        model.steady = std::min((double)sparks_.size(), rocketSparks + groundSparks);
+        return model;
+    }
+
+    void setSeed(uint32_t seed) override {
+        rng_.seed(seed);
+    }
+
     void update() override {
         float dt = (1.0f / fps_) * timeScale_;
         float time = frameCount_ * dt;
@@ -2,16 +2,113 @@
 // 2D flame and smoke fluid simulation (CPU)
 
 #include "effect_generator.h"
+#include "perf_stats.h"
 #include <algorithm>
 #include <cmath>
+#include <condition_variable>
 #include <cstdint>
 #include <cstdlib>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <random>
 #include <sstream>
 #include <thread>
 #include <vector>
 
+namespace {
+
+// Long-lived helper threads for FlameEffect::parallelRows. The solver splits
+// rows a dozen times per frame; reusing the threads keeps thread creation (and
+// the per-thread --stats counters) out of the phases being measured.
+class RowWorkers {
+public:
+    using Call = void (*)(const void* ctx, int yBegin, int yEnd);
+
+    explicit RowWorkers(int helpers) {
+        threads_.reserve((size_t)helpers);
+        for (int w = 0; w < helpers; ++w) threads_.emplace_back([this, w]() { helperLoop(w); });
+    }
+
+    ~RowWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            stopping_ = true;
+        }
+        start_.notify_all();
+        for (auto& t : threads_) t.join();
+    }
+
+    RowWorkers(const RowWorkers&) = delete;
+    RowWorkers& operator=(const RowWorkers&) = delete;
+
+    int helpers() const { return (int)threads_.size(); }
+
+    // Helper w takes rows [yBegin + w*chunk, +chunk); the caller takes the rest.
+    void run(int yBegin, int yEnd, int chunk, Call call, const void* ctx) {
+        std::lock_guard<std::mutex> dispatch(dispatchMu_);
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            yBegin_ = yBegin;
+            yEnd_ = yEnd;
+            chunk_ = chunk;
+            call_ = call;
+            ctx_ = ctx;
+            parent_ = perfstats::PhaseScope::current();
+            pending_ = helpers();
+            ++generation_;
+        }
+        start_.notify_all();
+
+        int mainA = yBegin + helpers() * chunk;
+        if (mainA < yEnd) call(ctx, mainA, yEnd);
+
+        std::unique_lock<std::mutex> lock(mu_);
+        done_.wait(lock, [this]() { return pending_ == 0; });
+    }
+
+private:
+    void helperLoop(int w) {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mu_);
+        for (;;) {
+            start_.wait(lock, [&]() { return stopping_ || generation_ != seen; });
+            if (stopping_) return;
+            seen = generation_;
+            int a = yBegin_ + w * chunk_;
+            int b = std::min(yEnd_, a + chunk_);
+            Call call = call_;
+            const void* ctx = ctx_;
+            perfstats::PhaseScope* parent = parent_;
+            lock.unlock();
+            if (a < b) {
+                perfstats::HelperScope scope(parent);
+                call(ctx, a, b);
+            }
+            lock.lock();
+            if (--pending_ == 0) done_.notify_one();
+        }
+    }
+
+    std::mutex dispatchMu_;
+    std::mutex mu_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+    uint64_t generation_ = 0;
+    int pending_ = 0;
+    bool stopping_ = false;
+    int yBegin_ = 0;
+    int yEnd_ = 0;
+    int chunk_ = 0;
+    Call call_ = nullptr;
+    const void* ctx_ = nullptr;
+    perfstats::PhaseScope* parent_ = nullptr;
+    std::vector<std::thread> threads_;
+};
+
+} // namespace
+
 class FlameEffect : public Effect {
 private:
     static constexpr float kUnsetPx = -1.0e30f;
@@ -22,6 +119,32 @@ private:
         float scale = 1.0f;
     };
 
+    // Burner model, placement and injection strengths for one group of
+    // sources. Several groups share the same velocity/temperature/smoke
+    // fields, so e.g. a candle next to a smoke plume needs only one solver.
+    struct EmitterGroup {
+        float sourceWidth = 0.02f;  // internal normalized base width
+        float sourceHeight = 0.12f; // internal normalized source region height
+        // CLI/API values in output pixels. If unset, keep preset/internal normalized values.
+        float sourceWidthPx = kUnsetPx;
+        float sourceHeightPx = kUnsetPx;
+        bool sourcePointsArePixels = false;
+        bool sourcePointsPlaced = false; // set by --sources or a preset layout
+        float sourceSpread = 1.75f; // width expansion above base
+        int burnerMode = 1;         // 0=gaussian, 1=tiki, 2=hybrid, 3=cloud
+        float sourceHeat = 3.2f;
+        float sourceSmoke = 1.1f;
+        float sourceUpdraft = 200.0f;
+        float turbulence = 18.0f;
+        float wobble = 0.1f;
+        float flicker = 0.75f;      // heat flicker amount (0..1+)
+        float heatFlickerGain = 1.0f;
+        float heatFlickerTarget = 1.0f;
+        float heatFlickerTimer = 0.0f;
+        float heatFlickerRecover = 1.1f;
+        std::vector<SourcePoint> sourcePoints{{0.5f, 0.97f, 1.0f}};
+    };
+
     int width_ = 0;
     int height_ = 0;
     int fps_ = 30;
@@ -30,6 +153,10 @@ private:
     float simMultiplier_ = 2.0f;
     int simWidth_ = 0;
     int simHeight_ = 0;
+    // Shading grid divisor: 1 = shade every output pixel, 0 = match the sim grid.
+    float shadeMultiplier_ = 1.0f;
+    int shadeWidth_ = 0;
+    int shadeHeight_ = 0;
     float simPadLeft_ = 0.25f;
     float simPadRight_ = 0.25f;
     float simPadTop_ = 0.25f;
@@ -39,22 +166,9 @@ private:
     int pressureIters_ = 12;
     int diffusionIters_ = 1;
     int threadsOpt_ = 0; // 0 = auto
+    int tunedThreads_ = 0; // from --autotune / tuning cache, used when threadsOpt_ is auto
 
     float timeScale_ = 1.0f;
-    float sourceWidth_ = 0.02f;  // internal normalized base width
-    float sourceHeight_ = 0.12f; // internal normalized source region height
-    // CLI/API values in output pixels. If unset, keep preset/internal normalized values.
-    float sourceWidthPx_ = kUnsetPx;
-    float sourceHeightPx_ = kUnsetPx;
-    bool sourcePointsArePixels_ = false;
-    float sourceSpread_ = 1.75f; // width expansion above base
-    int burnerMode_ = 1;         // 0=gaussian, 1=tiki, 2=hybrid, 3=cloud
-    float sourceHeat_ = 3.2f;
-    float sourceSmoke_ = 1.1f;
-    float sourceUpdraft_ = 200.0f;
-    float turbulence_ = 18.0f;
-    float wobble_ = 0.1f;
-    float flicker_ = 0.75f;      // heat flicker amount (0..1+)
     float crosswind_ = 6.0f;
     float stir_ = 0.0f;
     float stirScale_ = 1.8f;
@@ -79,10 +193,6 @@ private:
     float ageCooling_ = 0.68f;
     float agePower_ = 1.5f;
     float ageTaper_ = 1.1f;
-    float heatFlickerGain_ = 1.0f;
-    float heatFlickerTarget_ = 1.0f;
-    float heatFlickerTimer_ = 0.0f;
-    float heatFlickerRecover_ = 1.1f;
     std::mt19937 rng_{std::random_device{}()};
 
     std::vector<float> u_;
@@ -99,7 +209,15 @@ private:
     std::vector<float> pressureTmp_;
     std::vector<float> divergence_;
     std::vector<float> curl_;
-    std::vector<SourcePoint> sourcePoints_{{0.5f, 0.97f, 1.0f}};
+    // Shaded colour per shading cell: premultiplied emission RGB + smoke alpha.
+    std::vector<float> shadeRGBA_;
+    std::vector<EmitterGroup> emitters_{EmitterGroup{}};
+    // Ambient airflow jitter per sim column: the wobble of the group whose
+    // nearest source lies closest to that column.
+    std::vector<float> columnWobble_;
+    float maxWobble_ = 0.0f;
+    // Created on first use and resized when the worker count changes.
+    std::unique_ptr<RowWorkers> rowWorkers_;
 
     inline int idx(int x, int y) const { return y * simWidth_ + x; }
 
@@ -141,204 +259,198 @@ private:
             });
         }
         if (parsed.empty()) return false;
-        sourcePoints_ = std::move(parsed);
-        sourcePointsArePixels_ = true;
+        emitters_.back().sourcePoints = std::move(parsed);
+        emitters_.back().sourcePointsArePixels = true;
+        emitters_.back().sourcePointsPlaced = true;
         return true;
     }
 
-    bool applyPreset(const std::string& name) {
+    static bool isPresetName(const std::string& name) {
+        return name == "smallcandle" || name == "candle" || name == "campfire" ||
+               name == "bonfire" || name == "smoketrail" || name == "mist";
+    }
+
+    // With emitterOnly set (a preset given after --emitter) only the burner
+    // fields of the current emitter group are touched; solver and shading
+    // settings stay as configured for the whole stage.
+    bool applyPreset(const std::string& name, bool emitterOnly = false) {
+        EmitterGroup& e = emitters_.back();
         if (name == "smallcandle") {
-            burnerMode_ = 0; // gaussian
-            pressureIters_ = 16;
-            sourceWidth_ = 0.008f;
-            sourceHeight_ = 0.075f;
-            sourceSpread_ = 1.05f;
-            sourceHeat_ = 1.9f;
-            sourceSmoke_ = 0.20f;
-            sourceUpdraft_ = 110.0f;
-            turbulence_ = 6.0f;
-            wobble_ = 0.05f;
-            flicker_ = 0.38f;
-            crosswind_ = 1.2f;
-            initialAir_ = 8.0f;
-            buoyancy_ = 105.0f;
-            cooling_ = 0.72f;
-            coolingAloftBoost_ = 1.0f;
-            smokeDissipation_ = 0.90f;
-            vorticity_ = 28.0f;
-            flameIntensity_ = 1.05f;
-            smokiness_ = 0.10f;
-            smokeDarkness_ = 0.04f;
-            ageRate_ = 1.25f;
-            ageCooling_ = 1.35f;
-            ageTaper_ = 1.65f;
+            e.burnerMode = 0; // gaussian
+            e.sourceWidth = 0.008f;
+            e.sourceHeight = 0.075f;
+            e.sourceSpread = 1.05f;
+            e.sourceHeat = 1.9f;
+            e.sourceSmoke = 0.20f;
+            e.sourceUpdraft = 110.0f;
+            e.turbulence = 6.0f;
+            e.wobble = 0.05f;
+            e.flicker = 0.38f;
+            if (!emitterOnly) {
+                pressureIters_ = 16;
+                crosswind_ = 1.2f;
+                initialAir_ = 8.0f;
+                buoyancy_ = 105.0f;
+                cooling_ = 0.72f;
+                coolingAloftBoost_ = 1.0f;
+                smokeDissipation_ = 0.90f;
+                vorticity_ = 28.0f;
+                flameIntensity_ = 1.05f;
+                smokiness_ = 0.10f;
+                smokeDarkness_ = 0.04f;
+                ageRate_ = 1.25f;
+                ageCooling_ = 1.35f;
+                ageTaper_ = 1.65f;
+            }
             return true;
         }
         if (name == "candle") {
-            burnerMode_ = 0; // gaussian
-            pressureIters_ = 16;
-            sourceWidth_ = 0.012f;
-            sourceHeight_ = 0.10f;
-            sourceSpread_ = 1.15f;
-            sourceHeat_ = 2.4f;
-            sourceSmoke_ = 0.25f;
-            sourceUpdraft_ = 135.0f;
-            turbulence_ = 8.0f;
-            wobble_ = 0.06f;
-            flicker_ = 0.45f;
-            crosswind_ = 1.5f;
-            stir_ = 5.0f;
-            stirScale_ = 3.3f;
-            stirSpeed_ = 0.03f;
-            stirAnisotropy_ = 0.74f;
-            initialAir_ = 10.0f;
-            buoyancy_ = 120.0f;
-            cooling_ = 0.65f;
-            coolingAloftBoost_ = 0.90f;
-            smokeDissipation_ = 0.85f;
-            vorticity_ = 35.0f;
-            flameIntensity_ = 1.15f;
-            smokiness_ = 0.12f;
-            smokeDarkness_ = 0.05f;
-            ageRate_ = 1.2f;
-            ageCooling_ = 1.2f;
-            ageTaper_ = 1.5f;
+            e.burnerMode = 0; // gaussian
+            e.sourceWidth = 0.012f;
+            e.sourceHeight = 0.10f;
+            e.sourceSpread = 1.15f;
+            e.sourceHeat = 2.4f;
+            e.sourceSmoke = 0.25f;
+            e.sourceUpdraft = 135.0f;
+            e.turbulence = 8.0f;
+            e.wobble = 0.06f;
+            e.flicker = 0.45f;
+            if (!emitterOnly) {
+                pressureIters_ = 16;
+                crosswind_ = 1.5f;
+                stir_ = 5.0f;
+                stirScale_ = 3.3f;
+                stirSpeed_ = 0.03f;
+                stirAnisotropy_ = 0.74f;
+                initialAir_ = 10.0f;
+                buoyancy_ = 120.0f;
+                cooling_ = 0.65f;
+                coolingAloftBoost_ = 0.90f;
+                smokeDissipation_ = 0.85f;
+                vorticity_ = 35.0f;
+                flameIntensity_ = 1.15f;
+                smokiness_ = 0.12f;
+                smokeDarkness_ = 0.05f;
+                ageRate_ = 1.2f;
+                ageCooling_ = 1.2f;
+                ageTaper_ = 1.5f;
+            }
             return true;
         }
         if (name == "campfire") {
-            burnerMode_ = 2; // hybrid
-            pressureIters_ = 12;
-            sourceWidth_ = 0.060f;
-            sourceHeight_ = 0.14f;
-            sourceSpread_ = 1.9f;
-            sourceHeat_ = 3.6f;
-            sourceSmoke_ = 1.5f;
-            sourceUpdraft_ = 145.0f;
-            turbulence_ = 30.0f;
-            wobble_ = 0.22f;
-            flicker_ = 0.80f;
-            crosswind_ = 6.5f;
-            stir_ = 7.0f;
-            stirScale_ = 1.00f;
-            stirSpeed_ = 0.05f;
-            stirAnisotropy_ = 0.30f;
-            initialAir_ = 30.0f;
-            buoyancy_ = 180.0f;
-            cooling_ = 0.38f;
-            coolingAloftBoost_ = 0.42f;
-            smokeDissipation_ = 0.35f;
-            vorticity_ = 70.0f;
-            flameIntensity_ = 1.35f;
-            smokiness_ = 1.1f;
-            smokeDarkness_ = 0.42f;
-            ageRate_ = 1.5f;
-            ageCooling_ = 0.70f;
-            ageTaper_ = 1.1f;
+            e.burnerMode = 2; // hybrid
+            e.sourceWidth = 0.060f;
+            e.sourceHeight = 0.14f;
+            e.sourceSpread = 1.9f;
+            e.sourceHeat = 3.6f;
+            e.sourceSmoke = 1.5f;
+            e.sourceUpdraft = 145.0f;
+            e.turbulence = 30.0f;
+            e.wobble = 0.22f;
+            e.flicker = 0.80f;
+            if (!emitterOnly) {
+                pressureIters_ = 12;
+                crosswind_ = 6.5f;
+                stir_ = 7.0f;
+                stirScale_ = 1.00f;
+                stirSpeed_ = 0.05f;
+                stirAnisotropy_ = 0.30f;
+                initialAir_ = 30.0f;
+                buoyancy_ = 180.0f;
+                cooling_ = 0.38f;
+                coolingAloftBoost_ = 0.42f;
+                smokeDissipation_ = 0.35f;
+                vorticity_ = 70.0f;
+                flameIntensity_ = 1.35f;
+                smokiness_ = 1.1f;
+                smokeDarkness_ = 0.42f;
+                ageRate_ = 1.5f;
+                ageCooling_ = 0.70f;
+                ageTaper_ = 1.1f;
+            }
             return true;
         }
         if (name == "bonfire") {
-            burnerMode_ = 2; // hybrid
-            pressureIters_ = 10;
-            sourceWidth_ = 0.10f;
-            sourceHeight_ = 0.16f;
-            sourceSpread_ = 2.2f;
-            sourceHeat_ = 4.5f;
-            sourceSmoke_ = 2.0f;
-            sourceUpdraft_ = 180.0f;
-            turbulence_ = 72.0f;
-            wobble_ = 0.35f;
-            flicker_ = 2.0f;
-            crosswind_ = 24.0f;
-            stir_ = 10.0f;
-            stirScale_ = 0.90f;
-            stirSpeed_ = 0.05f;
-            stirAnisotropy_ = 0.35f;
-            initialAir_ = 65.0f;
-            buoyancy_ = 240.0f;
-            cooling_ = 0.30f;
-            coolingAloftBoost_ = 0.35f;
-            smokeDissipation_ = 0.26f;
-            vorticity_ = 85.0f;
-            flameIntensity_ = 1.55f;
-            smokiness_ = 1.5f;
-            smokeDarkness_ = 0.70f;
-            ageRate_ = 1.3f;
-            ageCooling_ = 0.60f;
-            ageTaper_ = 1.0f;
+            e.burnerMode = 2; // hybrid
+            e.sourceWidth = 0.10f;
+            e.sourceHeight = 0.16f;
+            e.sourceSpread = 2.2f;
+            e.sourceHeat = 4.5f;
+            e.sourceSmoke = 2.0f;
+            e.sourceUpdraft = 180.0f;
+            e.turbulence = 72.0f;
+            e.wobble = 0.35f;
+            e.flicker = 2.0f;
+            if (!emitterOnly) {
+                pressureIters_ = 10;
+                crosswind_ = 24.0f;
+                stir_ = 10.0f;
+                stirScale_ = 0.90f;
+                stirSpeed_ = 0.05f;
+                stirAnisotropy_ = 0.35f;
+                initialAir_ = 65.0f;
+                buoyancy_ = 240.0f;
+                cooling_ = 0.30f;
+                coolingAloftBoost_ = 0.35f;
+                smokeDissipation_ = 0.26f;
+                vorticity_ = 85.0f;
+                flameIntensity_ = 1.55f;
+                smokiness_ = 1.5f;
+                smokeDarkness_ = 0.70f;
+                ageRate_ = 1.3f;
+                ageCooling_ = 0.60f;
+                ageTaper_ = 1.0f;
+            }
             return true;
         }
         if (name == "smoketrail") {
-            burnerMode_ = 3; // cloud
-            pressureIters_ = 12;
-            sourceWidth_ = 0.04f;
-            sourceHeight_ = 0.08f;
-            sourceSpread_ = 1.5f;
-            sourceHeat_ = 3.5f;
-            sourceSmoke_ = 1.1f;
-            sourceUpdraft_ = 70.0f;
-            turbulence_ = 80.0f;
-            wobble_ = 0.12f;
-            flicker_ = 0.75f;
-            crosswind_ = 20.0f;
-            stir_ = 15.0f;
-            stirScale_ = 1.20f;
-            stirSpeed_ = 0.10f;
-            initialAir_ = 40.0f;
-            buoyancy_ = 220.0f;
-            cooling_ = 0.2f;
-            coolingAloftBoost_ = 0.01f;
-            smokeDissipation_ = 0.001f;
-            velocityDamping_ = 0.06f;
-            vorticity_ = 99.0f;
-            flameIntensity_ = 0.0f;  // smoke-only look
-            smokeIntensity_ = 0.7f;
-            smokiness_ = 1.6f;
-            smokeDarkness_ = 0.1f;
-            ageRate_ = 0.7f;
-            ageCooling_ = 0.25f;
-            agePower_ = 1.0f;
-            ageTaper_ = 1.1f;
+            e.burnerMode = 3; // cloud
+            e.sourceWidth = 0.04f;
+            e.sourceHeight = 0.08f;
+            e.sourceSpread = 1.5f;
+            e.sourceHeat = 3.5f;
+            e.sourceSmoke = 1.1f;
+            e.sourceUpdraft = 70.0f;
+            e.turbulence = 80.0f;
+            e.wobble = 0.12f;
+            e.flicker = 0.75f;
+            if (!emitterOnly) {
+                pressureIters_ = 12;
+                crosswind_ = 20.0f;
+                stir_ = 15.0f;
+                stirScale_ = 1.20f;
+                stirSpeed_ = 0.10f;
+                initialAir_ = 40.0f;
+                buoyancy_ = 220.0f;
+                cooling_ = 0.2f;
+                coolingAloftBoost_ = 0.01f;
+                smokeDissipation_ = 0.001f;
+                velocityDamping_ = 0.06f;
+                vorticity_ = 99.0f;
+                flameIntensity_ = 0.0f;  // smoke-only look
+                smokeIntensity_ = 0.7f;
+                smokiness_ = 1.6f;
+                smokeDarkness_ = 0.1f;
+                ageRate_ = 0.7f;
+                ageCooling_ = 0.25f;
+                agePower_ = 1.0f;
+                ageTaper_ = 1.1f;
+            }
             return true;
         }
         if (name == "mist") {
-            burnerMode_ = 3; // cloud
-            simPadLeft_ = 0.5f;
-            simPadRight_ = 0.5f;
-            simPadTop_ = 0.5f;
-            simPadBottom_ = 0.5f;
-            pressureIters_ = 16;
-            sourceWidth_ = 0.18f;
-            sourceHeight_ = 0.10f;
-            sourceSpread_ = 1.4f;
-            sourceHeat_ = 0.20f;
-            sourceSmoke_ = 0.90f;
-            sourceUpdraft_ = 6.0f;
-            turbulence_ = 65.0f;
-            wobble_ = 0.30f;
-            flicker_ = 0.0f;
-            crosswind_ = 12.0f;
-            stir_ = 28.0f;
-            stirScale_ = 1.20f;
-            stirSpeed_ = 0.10f;
-            stirAnisotropy_ = 0.74f;
-            initialAir_ = 60.0f;
-            buoyancy_ = 25.0f;
-            cooling_ = 0.35f;
-            coolingAloftBoost_ = 0.0f;
-            smokeDissipation_ = 0.35f;
-            velocityDamping_ = 0.05f;
-            vorticity_ = 80.0f;
-            flameIntensity_ = 0.0f;  // smoke/mist only
-            smokeIntensity_ = 0.52f;
-            smokiness_ = 0.95f;
-            smokeDarkness_ = 0.0f;
-            ageRate_ = 0.25f;
-            ageCooling_ = 0.22f;
-            agePower_ = 1.0f;
-            ageTaper_ = 0.9f;
-
+            e.burnerMode = 3; // cloud
+            e.sourceWidth = 0.18f;
+            e.sourceHeight = 0.10f;
+            e.sourceSpread = 1.4f;
+            e.sourceHeat = 0.20f;
+            e.sourceSmoke = 0.90f;
+            e.sourceUpdraft = 6.0f;
+            e.turbulence = 65.0f;
+            e.wobble = 0.30f;
+            e.flicker = 0.0f;
             // Wide, staggered cloud emitters to fill the scene with lateral wafting mist.
-            sourcePoints_ = {
+            e.sourcePoints = {
                 {0.08f, 1.20f, 0.75f},
                 {0.26f, 1.16f, 0.95f},
                 {0.44f, 1.24f, 1.05f},
@@ -349,7 +461,35 @@ private:
                 {0.52f, -0.24f, 0.65f},
                 {0.86f, -0.16f, 0.50f},
             };
-            sourcePointsArePixels_ = false;
+            e.sourcePointsArePixels = false;
+            e.sourcePointsPlaced = true;
+            if (!emitterOnly) {
+                simPadLeft_ = 0.5f;
+                simPadRight_ = 0.5f;
+                simPadTop_ = 0.5f;
+                simPadBottom_ = 0.5f;
+                pressureIters_ = 16;
+                crosswind_ = 12.0f;
+                stir_ = 28.0f;
+                stirScale_ = 1.20f;
+                stirSpeed_ = 0.10f;
+                stirAnisotropy_ = 0.74f;
+                initialAir_ = 60.0f;
+                buoyancy_ = 25.0f;
+                cooling_ = 0.35f;
+                coolingAloftBoost_ = 0.0f;
+                smokeDissipation_ = 0.35f;
+                velocityDamping_ = 0.05f;
+                vorticity_ = 80.0f;
+                flameIntensity_ = 0.0f;  // smoke/mist only
+                smokeIntensity_ = 0.52f;
+                smokiness_ = 0.95f;
+                smokeDarkness_ = 0.0f;
+                ageRate_ = 0.25f;
+                ageCooling_ = 0.22f;
+                agePower_ = 1.0f;
+                ageTaper_ = 0.9f;
+            }
             return true;
         }
         return false;
@@ -359,6 +499,7 @@ private:
         int hw = (int)std::thread::hardware_concurrency();
         if (hw <= 0) hw = 1;
         if (threadsOpt_ > 0) return std::max(1, threadsOpt_);
+        if (tunedThreads_ > 0) return tunedThreads_;
         return hw;
     }
 
@@ -374,20 +515,11 @@ private:
         }
 
         int chunk = (rows + workers - 1) / workers;
-        std::vector<std::thread> pool;
-        pool.reserve((size_t)std::max(0, workers - 1));
-
-        for (int w = 0; w < workers - 1; ++w) {
-            int a = yBegin + w * chunk;
-            int b = std::min(yEnd, a + chunk);
-            if (a >= b) break;
-            pool.emplace_back([&fn, a, b]() { fn(a, b); });
+        if (!rowWorkers_ || rowWorkers_->helpers() != workers - 1) {
+            rowWorkers_ = std::make_unique<RowWorkers>(workers - 1);
         }
-
-        int mainA = yBegin + (workers - 1) * chunk;
-        if (mainA < yEnd) fn(mainA, yEnd);
-
-        for (auto& t : pool) t.join();
+        rowWorkers_->run(yBegin, yEnd, chunk,
+                         [](const void* ctx, int a, int b) { (*static_cast<const Fn*>(ctx))(a, b); }, &fn);
     }
 
     static float hash3(int x, int y, int z) {
@@ -453,8 +585,29 @@ private:
         clearVelocityBoundaries();
     }
 
+    void assignColumnWobble() {
+        float domainW = 1.0f + std::max(0.0f, simPadLeft_) + std::max(0.0f, simPadRight_);
+        columnWobble_.assign(simWidth_, emitters_.front().wobble);
+        maxWobble_ = 0.0f;
+        for (const auto& e : emitters_) maxWobble_ = std::max(maxWobble_, e.wobble);
+        if (emitters_.size() < 2) return;
+        for (int x = 0; x < simWidth_; ++x) {
+            float best = std::numeric_limits<float>::max();
+            for (const auto& e : emitters_) {
+                for (const auto& sp : e.sourcePoints) {
+                    float cx = (sp.x + simPadLeft_) / std::max(0.0001f, domainW) * (simWidth_ - 1);
+                    float d = std::fabs((float)x - cx);
+                    if (d < best) {
+                        best = d;
+                        columnWobble_[x] = e.wobble;
+                    }
+                }
+            }
+        }
+    }
+
     void applyAmbientAirMotion(float dt) {
-        if (crosswind_ <= 0.0f && wobble_ <= 0.0f && stir_ <= 0.0f) return;
+        if (crosswind_ <= 0.0f && maxWobble_ <= 0.0f && stir_ <= 0.0f) return;
         float t = frameCount_ / std::max(1.0f, (float)fps_);
         parallelRows(1, simHeight_ - 1, [&](int y0, int y1) {
             for (int y = y0; y < y1; ++y) {
@@ -464,9 +617,10 @@ private:
                 for (int x = 1; x < simWidth_ - 1; ++x) {
                     int i = idx(x, y);
                     float localNoise = (hash3(x, y, frameCount_ + 1234) - 0.5f) * 2.0f;
+                    const float wobble = columnWobble_[x];
 
-                    float ambientU = globalWind + localNoise * wobble_ * 4.0f;
-                    float ambientV = localNoise * wobble_ * 1.2f;
+                    float ambientU = globalWind + localNoise * wobble * 4.0f;
+                    float ambientV = localNoise * wobble * 1.2f;
 
                     // Room-scale stirring: coherent low-frequency flow that slowly evolves over time.
                     if (stir_ > 0.0f) {
@@ -503,33 +657,33 @@ private:
         });
     }
 
-    void updateHeatFlicker(float dt) {
-        if (flicker_ <= 0.0f) {
-            heatFlickerGain_ = 1.0f;
-            heatFlickerTarget_ = 1.0f;
-            heatFlickerTimer_ = 0.0f;
+    void updateHeatFlicker(EmitterGroup& e, float dt) {
+        if (e.flicker <= 0.0f) {
+            e.heatFlickerGain = 1.0f;
+            e.heatFlickerTarget = 1.0f;
+            e.heatFlickerTimer = 0.0f;
             return;
         }
 
-        heatFlickerTimer_ -= dt;
-        if (heatFlickerTimer_ <= 0.0f) {
+        e.heatFlickerTimer -= dt;
+        if (e.heatFlickerTimer <= 0.0f) {
             std::uniform_real_distribution<float> intervalDist(0.2f, 3.0f);
             std::uniform_real_distribution<float> unitDist(0.0f, 1.0f);
-            heatFlickerTimer_ = intervalDist(rng_);
+            e.heatFlickerTimer = intervalDist(rng_);
 
-            float f = std::clamp(flicker_, 0.0f, 1.5f);
+            float f = std::clamp(e.flicker, 0.0f, 1.5f);
             float minDrop = std::clamp(1.0f - f * 0.8f, 0.2f, 1.0f);
             float maxDrop = std::clamp(1.0f - f * 0.5f, minDrop, 1.0f);
             std::uniform_real_distribution<float> dropDist(minDrop, maxDrop);
-            heatFlickerGain_ *= dropDist(rng_);
-            heatFlickerGain_ = std::clamp(heatFlickerGain_, 0.15f, 2.0f);
+            e.heatFlickerGain *= dropDist(rng_);
+            e.heatFlickerGain = std::clamp(e.heatFlickerGain, 0.15f, 2.0f);
 
-            heatFlickerTarget_ = 1.0f + f * (0.1f + 0.35f * unitDist(rng_));
-            heatFlickerRecover_ = 0.8f + f * (1.4f + 0.6f * unitDist(rng_));
+            e.heatFlickerTarget = 1.0f + f * (0.1f + 0.35f * unitDist(rng_));
+            e.heatFlickerRecover = 0.8f + f * (1.4f + 0.6f * unitDist(rng_));
         }
 
-        float alpha = std::clamp(heatFlickerRecover_ * dt, 0.0f, 1.0f);
-        heatFlickerGain_ += (heatFlickerTarget_ - heatFlickerGain_) * alpha;
+        float alpha = std::clamp(e.heatFlickerRecover * dt, 0.0f, 1.0f);
+        e.heatFlickerGain += (e.heatFlickerTarget - e.heatFlickerGain) * alpha;
     }
 
     void addSources(float dt) {
@@ -542,20 +696,22 @@ private:
             float sourceUpdraft;
             float turbulence;
             float wobble;
+            float heatGain; // group flicker gain, applied at injection
         };
 
-        auto scaledEmitterParams = [&](float sourceScale) {
+        auto scaledEmitterParams = [&](const EmitterGroup& e, float sourceScale) {
             // Source scale multiplies the emitter knobs that differ between candle and smallcandle.
             float s = std::clamp(sourceScale, 0.0f, 8.0f);
             EmitterParams p;
-            p.sourceWidth = sourceWidth_ * s;
-            p.sourceHeight = sourceHeight_ * s;
-            p.sourceSpread = sourceSpread_ * s;
-            p.sourceHeat = sourceHeat_ * s;
-            p.sourceSmoke = sourceSmoke_ * s;
-            p.sourceUpdraft = sourceUpdraft_ * s;
-            p.turbulence = turbulence_ * s;
-            p.wobble = wobble_ * s;
+            p.sourceWidth = e.sourceWidth * s;
+            p.sourceHeight = e.sourceHeight * s;
+            p.sourceSpread = e.sourceSpread * s;
+            p.sourceHeat = e.sourceHeat * s;
+            p.sourceSmoke = e.sourceSmoke * s;
+            p.sourceUpdraft = e.sourceUpdraft * s;
+            p.turbulence = e.turbulence * s;
+            p.wobble = e.wobble * s;
+            p.heatGain = e.heatFlickerGain;
             return p;
         };
 
@@ -566,7 +722,6 @@ private:
         float visibleSimW = simWidth_ / std::max(0.0001f, domainW);
         float visibleSimH = simHeight_ / std::max(0.0001f, domainH);
         int phase = frameCount_;
-        std::vector<SourcePoint> activeSources = sourcePoints_;
 
         auto injectGaussian = [&](const SourcePoint& sp, float modeScale, const EmitterParams& ep) {
             float sxNorm = (sp.x + simPadLeft_) / std::max(0.0001f, domainW);
@@ -598,7 +753,7 @@ private:
                     float shape = xWeight * yWeight * pulse * modeScale;
 
                     int i = idx(x, y);
-                    temp_[i] += ep.sourceHeat * heatFlickerGain_ * shape * dt;
+                    temp_[i] += ep.sourceHeat * ep.heatGain * shape * dt;
                     smoke_[i] += ep.sourceSmoke * smokiness_ * (0.7f + 0.3f * n) * shape * dt;
                     age_[i] = std::min(age_[i], 0.03f + 0.05f * (1.0f - n));
                     v_[i] -= ep.sourceUpdraft * shape * dt;
@@ -636,7 +791,7 @@ private:
                     float shape = xWeight * yWeight * pulse * modeScale;
 
                     int i = idx(x, y);
-                    temp_[i] += ep.sourceHeat * heatFlickerGain_ * shape * dt;
+                    temp_[i] += ep.sourceHeat * ep.heatGain * shape * dt;
                     smoke_[i] += ep.sourceSmoke * smokiness_ * (0.65f + 0.35f * n) * shape * dt;
                     age_[i] = std::min(age_[i], 0.02f + 0.04f * (1.0f - n));
                     // Tiki base gives a slightly stronger base push.
@@ -690,7 +845,7 @@ private:
                         int i = idx(x, y);
 
                         smoke_[i] += ep.sourceSmoke * smokiness_ * 1.55f * blob * dt;
-                        temp_[i] += ep.sourceHeat * 0.42f * heatFlickerGain_ * blob * dt;
+                        temp_[i] += ep.sourceHeat * 0.42f * ep.heatGain * blob * dt;
                         age_[i] = std::min(age_[i], 0.03f + 0.08f * (1.0f - ragged));
 
                         float center = std::max(0.0f, 1.0f - std::fabs(dx));
@@ -703,17 +858,19 @@ private:
             }
         };
 
-        for (const auto& sp : activeSources) {
-            EmitterParams ep = scaledEmitterParams(sp.scale);
-            if (burnerMode_ == 1) {
-                injectTiki(sp, 1.0f, ep);
-            } else if (burnerMode_ == 2) {
-                injectGaussian(sp, 0.65f, ep);
-                injectTiki(sp, 0.45f, ep);
-            } else if (burnerMode_ == 3) {
-                injectCloud(sp, 1.0f, ep);
-            } else {
-                injectGaussian(sp, 1.0f, ep);
+        for (const auto& group : emitters_) {
+            for (const auto& sp : group.sourcePoints) {
+                EmitterParams ep = scaledEmitterParams(group, sp.scale);
+                if (group.burnerMode == 1) {
+                    injectTiki(sp, 1.0f, ep);
+                } else if (group.burnerMode == 2) {
+                    injectGaussian(sp, 0.65f, ep);
+                    injectTiki(sp, 0.45f, ep);
+                } else if (group.burnerMode == 3) {
+                    injectCloud(sp, 1.0f, ep);
+                } else {
+                    injectGaussian(sp, 1.0f, ep);
+                }
             }
         }
     }
@@ -886,7 +1043,7 @@ private:
     }
 
     void stepSimulation(float dt) {
-        updateHeatFlicker(dt);
+        for (auto& group : emitters_) updateHeatFlicker(group, dt);
         applyAmbientAirMotion(dt);
         addSources(dt);
 
@@ -949,26 +1106,52 @@ public:
         return "Authentic flame and smoke using 2D fluid dynamics on a configurable simulation grid";
     }
 
+    bool setWorkerThreads(int threads) override {
+        if (threadsOpt_ > 0) return false;
+        tunedThreads_ = std::max(1, threads);
+        return true;
+    }
+
+    static const char* burnerName(int mode) {
+        return (mode == 0) ? "gaussian" : (mode == 1 ? "tiki" : (mode == 2 ? "hybrid" : "cloud"));
+    }
+
+    // Solver cost is fixed by the grid and iteration counts.
+    CostModel costModel() const override {
+        CostModel model;
+        model.unit = "cell-iterations";
+        model.current = (double)simWidth_ * simHeight_ * substeps_ * (pressureIters_ + diffusionIters_ + 1);
+        model.steady = model.current;
+        return model;
+    }
+
     void printConfig(std::ostream& os) const override {
-        const char* burner = (burnerMode_ == 0) ? "gaussian" : (burnerMode_ == 1 ? "tiki" : (burnerMode_ == 2 ? "hybrid" : "cloud"));
-        os << "burner: " << burner << "\n";
         os << "sim: " << simWidth_ << "x" << simHeight_ << ", substeps=" << substeps_
            << ", pressure_iters=" << pressureIters_ << ", diffusion_iters=" << diffusionIters_
-           << ", threads=" << threadsOpt_ << "\n";
+           << ", threads=" << threadsOpt_;
+        if (threadsOpt_ <= 0 && tunedThreads_ > 0) os << " (tuned " << tunedThreads_ << ")";
+        os << "\n";
         os << "sim_multiplier=" << simMultiplier_ << "\n";
+        os << "shade: " << shadeWidth_ << "x" << shadeHeight_ << ", shade_multiplier=" << shadeMultiplier_ << "\n";
         os << "sim_padding: left=" << simPadLeft_ << ", right=" << simPadRight_
            << ", top=" << simPadTop_ << ", bottom=" << simPadBottom_ << "\n";
-        os << "sources: ";
-        for (size_t i = 0; i < sourcePoints_.size(); ++i) {
-            if (i) os << ";";
-            os << "[" << sourcePoints_[i].x << "," << sourcePoints_[i].y << "," << sourcePoints_[i].scale << "]";
+        for (size_t g = 0; g < emitters_.size(); ++g) {
+            const EmitterGroup& e = emitters_[g];
+            if (emitters_.size() > 1) os << "emitter " << (g + 1) << ":\n";
+            os << "burner: " << burnerName(e.burnerMode) << "\n";
+            os << "sources: ";
+            for (size_t i = 0; i < e.sourcePoints.size(); ++i) {
+                if (i) os << ";";
+                os << "[" << e.sourcePoints[i].x << "," << e.sourcePoints[i].y << "," << e.sourcePoints[i].scale << "]";
+            }
+            os << "\n";
+            os << "source_width=" << e.sourceWidth << ", source_height=" << e.sourceHeight
+               << ", source_spread=" << e.sourceSpread << ", source_heat=" << e.sourceHeat
+               << ", source_smoke=" << e.sourceSmoke << ", source_updraft=" << e.sourceUpdraft
+               << ", turbulence=" << e.turbulence << "\n";
+            os << "wobble=" << e.wobble << ", flicker=" << e.flicker << "\n";
         }
-        os << "\n";
-        os << "source_width=" << sourceWidth_ << ", source_height=" << sourceHeight_
-           << ", source_spread=" << sourceSpread_ << ", source_heat=" << sourceHeat_
-           << ", source_smoke=" << sourceSmoke_ << ", source_updraft=" << sourceUpdraft_
-           << ", turbulence=" << turbulence_ << "\n";
-        os << "wobble=" << wobble_ << ", flicker=" << flicker_ << ", crosswind=" << crosswind_
+        os << "crosswind=" << crosswind_
            << ", stir=" << stir_ << ", stir_scale=" << stirScale_
            << ", stir_speed=" << stirSpeed_ << ", stir_anisotropy=" << stirAnisotropy_
            << ", initial_air=" << initialAir_ << "\n";
@@ -987,6 +1170,7 @@ public:
         using Opt = EffectOption;
         std::vector<Opt> opts;
         opts.push_back({"--sim-multiplier", "float", 0.25, 16.0, true, "Simulation size divisor after padding expansion (output*(1+padding)/multiplier)", "2.0", true});
+        opts.push_back({"--shade-multiplier", "float", 0.0, 16.0, true, "Shading grid divisor (output/multiplier); shaded colour is bilinearly upscaled. 0 = match --sim-multiplier, 1 (default) = shade every output pixel with no upscaling and no speedup; use 2-4 to cut shading cost", "1.0", true});
         opts.push_back({"--sim-pad-left", "float", 0.0, 4.0, true, "Extra simulation width left of visible frame (in visible-frame widths)", "0.25", true});
         opts.push_back({"--sim-pad-right", "float", 0.0, 4.0, true, "Extra simulation width right of visible frame (in visible-frame widths)", "0.25", true});
         opts.push_back({"--sim-pad-top", "float", 0.0, 4.0, true, "Extra simulation height above visible frame (in visible-frame heights)", "0.25", true});
@@ -999,6 +1183,8 @@ public:
         opts.push_back({"--preset", "string", 0, 0, false, "Preset look", "", false,
                         {"smallcandle", "candle", "campfire", "bonfire", "smoketrail", "mist"}});
         opts.push_back({"--sources", "string", 0, 0, false, "Multiple burner points in output pixels as 'x1,y1,s1;x2,y2,s2;...' (scale s optional, default 1.0)", "", false});
+        opts.push_back({"--emitter", "string", 0, 0, false, "Start another emitter group sharing this simulation. Value is a preset whose burner settings seed the group, or 'same' to copy the previous group's burner settings; following burner/source options apply to the new group. Groups without --sources are spread evenly along the bottom edge", "", true,
+                        {"same", "smallcandle", "candle", "campfire", "bonfire", "smoketrail", "mist"}});
         opts.push_back({"--burner", "string", 0, 0, false, "Burner model", "tiki", false,
                         {"gaussian", "tiki", "hybrid", "cloud"}});
         opts.push_back({"--source-width", "float", 0.0, 10000000.0, true, "Base burner width in output pixels", "", false});
@@ -1038,6 +1224,7 @@ public:
     bool parseArgs(int argc, char** argv, int& i) override {
         std::string arg = argv[i];
         if (arg == "--sim-multiplier" && i + 1 < argc) { simMultiplier_ = std::atof(argv[++i]); return true; }
+        if (arg == "--shade-multiplier" && i + 1 < argc) { shadeMultiplier_ = std::atof(argv[++i]); return true; }
         if (arg == "--sim-pad-left" && i + 1 < argc) { simPadLeft_ = std::atof(argv[++i]); return true; }
         if (arg == "--sim-pad-right" && i + 1 < argc) { simPadRight_ = std::atof(argv[++i]); return true; }
         if (arg == "--sim-pad-top" && i + 1 < argc) { simPadTop_ = std::atof(argv[++i]); return true; }
@@ -1047,9 +1234,30 @@ public:
         if (arg == "--pressure-iters" && i + 1 < argc) { pressureIters_ = std::atoi(argv[++i]); return true; }
         if (arg == "--diffusion-iters" && i + 1 < argc) { diffusionIters_ = std::atoi(argv[++i]); return true; }
         if (arg == "--timescale" && i + 1 < argc) { timeScale_ = std::atof(argv[++i]); return true; }
+        if (arg == "--emitter" && i + 1 < argc) {
+            std::string v = argv[++i];
+            if (v == "same") {
+                // Copy the burner settings but not the layout, so the new
+                // group gets its own spot instead of stacking on the old one.
+                EmitterGroup copy = emitters_.back();
+                copy.sourcePoints = EmitterGroup{}.sourcePoints;
+                copy.sourcePointsArePixels = false;
+                copy.sourcePointsPlaced = false;
+                emitters_.push_back(copy);
+                return true;
+            }
+            if (!isPresetName(v)) {
+                std::cerr << "Invalid --emitter value '" << v
+                          << "'. Valid values: same, smallcandle, candle, campfire, bonfire, smoketrail, mist\n";
+                return false;
+            }
+            emitters_.emplace_back();
+            applyPreset(v, true);
+            return true;
+        }
         if (arg == "--preset" && i + 1 < argc) {
             std::string preset = argv[++i];
-            if (!applyPreset(preset)) {
+            if (!applyPreset(preset, emitters_.size() > 1)) {
                 std::cerr << "Invalid flame preset '" << preset
                           << "'. Valid values: smallcandle, candle, campfire, bonfire, smoketrail, mist\n";
                 return false;
@@ -1067,10 +1275,11 @@ public:
         }
         if (arg == "--burner" && i + 1 < argc) {
             std::string v = argv[++i];
-            if (v == "gaussian") burnerMode_ = 0;
-            else if (v == "tiki") burnerMode_ = 1;
-            else if (v == "hybrid") burnerMode_ = 2;
-            else if (v == "cloud") burnerMode_ = 3;
+            int& mode = emitters_.back().burnerMode;
+            if (v == "gaussian") mode = 0;
+            else if (v == "tiki") mode = 1;
+            else if (v == "hybrid") mode = 2;
+            else if (v == "cloud") mode = 3;
             else {
                 std::cerr << "Invalid --burner value '" << v
                           << "'. Valid values: gaussian, tiki, hybrid, cloud\n";
@@ -1078,15 +1287,15 @@ public:
             }
             return true;
         }
-        if (arg == "--source-width" && i + 1 < argc) { sourceWidthPx_ = std::atof(argv[++i]); return true; }
-        if (arg == "--source-height" && i + 1 < argc) { sourceHeightPx_ = std::atof(argv[++i]); return true; }
-        if (arg == "--source-spread" && i + 1 < argc) { sourceSpread_ = std::atof(argv[++i]); return true; }
-        if (arg == "--source-heat" && i + 1 < argc) { sourceHeat_ = std::atof(argv[++i]); return true; }
-        if (arg == "--source-smoke" && i + 1 < argc) { sourceSmoke_ = std::atof(argv[++i]); return true; }
-        if (arg == "--source-updraft" && i + 1 < argc) { sourceUpdraft_ = std::atof(argv[++i]); return true; }
-        if (arg == "--turbulence" && i + 1 < argc) { turbulence_ = std::atof(argv[++i]); return true; }
-        if (arg == "--wobble" && i + 1 < argc) { wobble_ = std::atof(argv[++i]); return true; }
-        if (arg == "--flicker" && i + 1 < argc) { flicker_ = std::atof(argv[++i]); return true; }
+        if (arg == "--source-width" && i + 1 < argc) { emitters_.back().sourceWidthPx = std::atof(argv[++i]); return true; }
+        if (arg == "--source-height" && i + 1 < argc) { emitters_.back().sourceHeightPx = std::atof(argv[++i]); return true; }
+        if (arg == "--source-spread" && i + 1 < argc) { emitters_.back().sourceSpread = std::atof(argv[++i]); return true; }
+        if (arg == "--source-heat" && i + 1 < argc) { emitters_.back().sourceHeat = std::atof(argv[++i]); return true; }
+        if (arg == "--source-smoke" && i + 1 < argc) { emitters_.back().sourceSmoke = std::atof(argv[++i]); return true; }
+        if (arg == "--source-updraft" && i + 1 < argc) { emitters_.back().sourceUpdraft = std::atof(argv[++i]); return true; }
+        if (arg == "--turbulence" && i + 1 < argc) { emitters_.back().turbulence = std::atof(argv[++i]); return true; }
+        if (arg == "--wobble" && i + 1 < argc) { emitters_.back().wobble = std::atof(argv[++i]); return true; }
+        if (arg == "--flicker" && i + 1 < argc) { emitters_.back().flicker = std::atof(argv[++i]); return true; }
         if (arg == "--crosswind" && i + 1 < argc) { crosswind_ = std::atof(argv[++i]); return true; }
         if (arg == "--stir" && i + 1 < argc) { stir_ = std::atof(argv[++i]); return true; }
         if (arg == "--stir-scale" && i + 1 < argc) { stirScale_ = std::atof(argv[++i]); return true; }
@@ -1133,31 +1342,58 @@ public:
         simWidth_ = std::clamp((int)std::lround(simWf), 64, 4096);
         simHeight_ = std::clamp((int)std::lround(simHf), 64, 4096);
 
+        shadeMultiplier_ = std::clamp(shadeMultiplier_, 0.0f, 16.0f);
+        float shadeDiv = (shadeMultiplier_ <= 0.0f) ? simMultiplier_ : std::max(1.0f, shadeMultiplier_);
+        shadeWidth_ = std::clamp((int)std::lround((float)width_ / shadeDiv), 1, width_);
+        shadeHeight_ = std::clamp((int)std::lround((float)height_ / shadeDiv), 1, height_);
+        if (shadeWidth_ == width_ && shadeHeight_ == height_) {
+            shadeRGBA_.clear();
+        } else {
+            shadeRGBA_.assign((size_t)shadeWidth_ * shadeHeight_ * 4, 0.0f);
+        }
+
+        // Groups without an explicit layout share the bottom edge evenly; a
+        // single such group keeps the centred default.
+        int autoPlaced = 0;
+        for (const auto& e : emitters_) {
+            if (!e.sourcePointsPlaced) ++autoPlaced;
+        }
+        int autoSlot = 0;
+        for (auto& e : emitters_) {
+            if (e.sourcePointsPlaced) continue;
+            for (auto& p : e.sourcePoints) {
+                p.x = (autoSlot + 0.5f) / (float)autoPlaced;
+            }
+            ++autoSlot;
+        }
+
         // Convert output-space pixel controls into internal normalized coordinates.
         float widthForNorm = std::max(1.0f, (float)width_);
         float heightForNorm = std::max(1.0f, (float)height_);
-        if (sourceWidthPx_ > kUnsetPx * 0.5f) sourceWidth_ = sourceWidthPx_ / widthForNorm;
-        if (sourceHeightPx_ > kUnsetPx * 0.5f) sourceHeight_ = sourceHeightPx_ / heightForNorm;
-        if (sourcePointsArePixels_) {
-            for (auto& p : sourcePoints_) {
-                p.x /= widthForNorm;
-                p.y /= heightForNorm;
+        for (auto& e : emitters_) {
+            if (e.sourceWidthPx > kUnsetPx * 0.5f) e.sourceWidth = e.sourceWidthPx / widthForNorm;
+            if (e.sourceHeightPx > kUnsetPx * 0.5f) e.sourceHeight = e.sourceHeightPx / heightForNorm;
+            if (e.sourcePointsArePixels) {
+                for (auto& p : e.sourcePoints) {
+                    p.x /= widthForNorm;
+                    p.y /= heightForNorm;
+                }
+                e.sourcePointsArePixels = false;
             }
-            sourcePointsArePixels_ = false;
-        }
 
-        sourceWidth_ = std::clamp(sourceWidth_, 0.01f, 1.0f);
-        sourceHeight_ = std::clamp(sourceHeight_, 0.01f, 1.0f);
-        sourceSpread_ = std::clamp(sourceSpread_, 0.2f, 4.0f);
-        burnerMode_ = std::clamp(burnerMode_, 0, 3);
-        timeScale_ = std::clamp(timeScale_, 0.1f, 5.0f);
-        for (auto& p : sourcePoints_) {
-            p.x = std::clamp(p.x, -10.0f, 10.0f);
-            p.y = std::clamp(p.y, -10.0f, 10.0f);
-            p.scale = std::clamp(p.scale, 0.0f, 8.0f);
+            e.sourceWidth = std::clamp(e.sourceWidth, 0.01f, 1.0f);
+            e.sourceHeight = std::clamp(e.sourceHeight, 0.01f, 1.0f);
+            e.sourceSpread = std::clamp(e.sourceSpread, 0.2f, 4.0f);
+            e.burnerMode = std::clamp(e.burnerMode, 0, 3);
+            for (auto& p : e.sourcePoints) {
+                p.x = std::clamp(p.x, -10.0f, 10.0f);
+                p.y = std::clamp(p.y, -10.0f, 10.0f);
+                p.scale = std::clamp(p.scale, 0.0f, 8.0f);
+            }
+            e.wobble = std::clamp(e.wobble, 0.0f, 3.0f);
+            e.flicker = std::clamp(e.flicker, 0.0f, 1.5f);
         }
-        wobble_ = std::clamp(wobble_, 0.0f, 3.0f);
-        flicker_ = std::clamp(flicker_, 0.0f, 1.5f);
+        timeScale_ = std::clamp(timeScale_, 0.1f, 5.0f);
         crosswind_ = std::clamp(crosswind_, 0.0f, 80.0f);
         stir_ = std::clamp(stir_, 0.0f, 80.0f);
         stirScale_ = std::clamp(stirScale_, 0.2f, 6.0f);
@@ -1189,66 +1425,159 @@ public:
         pressureTmp_.assign(n, 0.0f);
         divergence_.assign(n, 0.0f);
         curl_.assign(n, 0.0f);
+        assignColumnWobble();
         seedInitialAirFlow();
         return true;
     }
 
+    struct Shade {
+        float smoke[3];
+        float smokeAlpha;
+        float flame[3]; // flame light, already scaled by intensity and fade
+    };
+
+    // Shade the flame/smoke state at a sim-space position.
+    void shadeSample(float sx, float sy, float fadeMultiplier, Shade& out) const {
+        float t = sampleBilinear(temp_, sx, sy);
+        float s = sampleBilinear(smoke_, sx, sy);
+        float a = sampleBilinear(age_, sx, sy);
+
+        // Smooth non-threshold flame visibility:
+        // heat follows a soft-logistic curve and fades continuously with thermal age.
+        float heatTerm = std::pow(t / (t + flameCutoff_ + 1e-4f), flameSharpness_);
+        float ageFade = 1.0f / (1.0f + std::pow(std::max(0.0f, a) * ageTaper_, agePower_));
+        float flame = clamp01(heatTerm * ageFade * clamp01(1.10f - s * 0.62f));
+        float smoke = clamp01(s * (0.55f + 0.75f * smokiness_));
+
+        float fr, fg, fb;
+        flamePalette(clamp01(flame * 1.2f), fr, fg, fb);
+
+        float flameAdd = flameIntensity_ * flame * fadeMultiplier;
+        float smokeAlpha = smokeIntensity_ * smokiness_ * smoke * (1.0f - 0.6f * flame) * fadeMultiplier;
+        smokeAlpha = clamp01(smokeAlpha);
+
+        float heatMix = clamp01(t * 0.7f);
+        float lightShade = 0.30f + 0.35f * heatMix;
+        float darkShade = 0.01f + 0.10f * heatMix;
+        float smokeShade = lightShade * (1.0f - smokeDarkness_) + darkShade * smokeDarkness_;
+        float smokeR = smokeShade;
+        float smokeG = smokeShade;
+        float smokeB = smokeShade + 0.01f * (1.0f - smokeDarkness_);
+
+        out.smoke[0] = smokeR;
+        out.smoke[1] = smokeG;
+        out.smoke[2] = smokeB;
+        out.smokeAlpha = smokeAlpha;
+        out.flame[0] = fr * flameAdd;
+        out.flame[1] = fg * flameAdd;
+        out.flame[2] = fb * flameAdd;
+    }
+
+    // Full-resolution compositing: blend the smoke over, then add flame light.
+    static void compositeShade(uint8_t* px, const Shade& sh) {
+        for (int c = 0; c < 3; ++c) {
+            float dst = px[c] / 255.0f;
+            dst = dst * (1.0f - sh.smokeAlpha) + sh.smoke[c] * sh.smokeAlpha;
+            dst = std::min(1.0f, dst + sh.flame[c]);
+            px[c] = (uint8_t)(dst * 255.0f);
+        }
+    }
+
+    // Reduced-grid cells hold the smoke colour premultiplied by alpha plus
+    // the flame light as RGB and the smoke alpha as A, so they interpolate
+    // linearly; compositing is then dst = min(1, dst * (1 - a) + rgb).
+    static void compositeShadeCell(uint8_t* px, const float* rgba) {
+        float keep = 1.0f - rgba[3];
+        for (int c = 0; c < 3; ++c) {
+            float dst = px[c] / 255.0f;
+            dst = std::min(1.0f, dst * keep + rgba[c]);
+            px[c] = (uint8_t)(dst * 255.0f);
+        }
+    }
+
     void renderFrame(std::vector<uint8_t>& frame, bool /*hasBackground*/, float fadeMultiplier) override {
         float padX = std::max(0.0f, simPadLeft_) + std::max(0.0f, simPadRight_);
         float padY = std::max(0.0f, simPadTop_) + std::max(0.0f, simPadBottom_);
         float domainW = 1.0f + padX;
         float domainH = 1.0f + padY;
 
-        for (int y = 0; y < height_; ++y) {
-            float vy = ((float)y + 0.5f) / std::max(1, height_);
-            float sy = ((vy + simPadTop_) / std::max(0.0001f, domainH)) * (simHeight_ - 1);
-            for (int x = 0; x < width_; ++x) {
-                float vx = ((float)x + 0.5f) / std::max(1, width_);
-                float sx = ((vx + simPadLeft_) / std::max(0.0001f, domainW)) * (simWidth_ - 1);
-                float t = sampleBilinear(temp_, sx, sy);
-                float s = sampleBilinear(smoke_, sx, sy);
-                float a = sampleBilinear(age_, sx, sy);
-
-                // Smooth non-threshold flame visibility:
-                // heat follows a soft-logistic curve and fades continuously with thermal age.
-                float heatTerm = std::pow(t / (t + flameCutoff_ + 1e-4f), flameSharpness_);
-                float ageFade = 1.0f / (1.0f + std::pow(std::max(0.0f, a) * ageTaper_, agePower_));
-                float flame = clamp01(heatTerm * ageFade * clamp01(1.10f - s * 0.62f));
-                float smoke = clamp01(s * (0.55f + 0.75f * smokiness_));
-
-                float fr, fg, fb;
-                flamePalette(clamp01(flame * 1.2f), fr, fg, fb);
-
-                float flameAdd = flameIntensity_ * flame * fadeMultiplier;
-                float smokeAlpha = smokeIntensity_ * smokiness_ * smoke * (1.0f - 0.6f * flame) * fadeMultiplier;
-                smokeAlpha = clamp01(smokeAlpha);
-
-                float heatMix = clamp01(t * 0.7f);
-                float lightShade = 0.30f + 0.35f * heatMix;
-                float darkShade = 0.01f + 0.10f * heatMix;
-                float smokeShade = lightShade * (1.0f - smokeDarkness_) + darkShade * smokeDarkness_;
-                float smokeR = smokeShade;
-                float smokeG = smokeShade;
-                float smokeB = smokeShade + 0.01f * (1.0f - smokeDarkness_);
-
-                int i = (y * width_ + x) * 3;
-                float dstR = frame[i + 0] / 255.0f;
-                float dstG = frame[i + 1] / 255.0f;
-                float dstB = frame[i + 2] / 255.0f;
-
-                dstR = dstR * (1.0f - smokeAlpha) + smokeR * smokeAlpha;
-                dstG = dstG * (1.0f - smokeAlpha) + smokeG * smokeAlpha;
-                dstB = dstB * (1.0f - smokeAlpha) + smokeB * smokeAlpha;
-
-                dstR = std::min(1.0f, dstR + fr * flameAdd);
-                dstG = std::min(1.0f, dstG + fg * flameAdd);
-                dstB = std::min(1.0f, dstB + fb * flameAdd);
-
-                frame[i + 0] = (uint8_t)(dstR * 255.0f);
-                frame[i + 1] = (uint8_t)(dstG * 255.0f);
-                frame[i + 2] = (uint8_t)(dstB * 255.0f);
+        if (shadeWidth_ == width_ && shadeHeight_ == height_) {
+            parallelRows(0, height_, [&](int yBegin, int yEnd) {
+                for (int y = yBegin; y < yEnd; ++y) {
+                    float vy = ((float)y + 0.5f) / std::max(1, height_);
+                    float sy = ((vy + simPadTop_) / std::max(0.0001f, domainH)) * (simHeight_ - 1);
+                    for (int x = 0; x < width_; ++x) {
+                        float vx = ((float)x + 0.5f) / std::max(1, width_);
+                        float sx = ((vx + simPadLeft_) / std::max(0.0001f, domainW)) * (simWidth_ - 1);
+                        Shade sh;
+                        shadeSample(sx, sy, fadeMultiplier, sh);
+                        compositeShade(&frame[(y * width_ + x) * 3], sh);
+                    }
+                }
+            });
+            return;
+        }
+
+        // Shade once per shading cell, then bilinearly upscale and composite.
+        parallelRows(0, shadeHeight_, [&](int yBegin, int yEnd) {
+            for (int y = yBegin; y < yEnd; ++y) {
+                float vy = ((float)y + 0.5f) / (float)shadeHeight_;
+                float sy = ((vy + simPadTop_) / std::max(0.0001f, domainH)) * (simHeight_ - 1);
+                float* row = &shadeRGBA_[(size_t)y * shadeWidth_ * 4];
+                for (int x = 0; x < shadeWidth_; ++x) {
+                    float vx = ((float)x + 0.5f) / (float)shadeWidth_;
+                    float sx = ((vx + simPadLeft_) / std::max(0.0001f, domainW)) * (simWidth_ - 1);
+                    Shade sh;
+                    shadeSample(sx, sy, fadeMultiplier, sh);
+                    float* cell = row + x * 4;
+                    for (int c = 0; c < 3; ++c) {
+                        cell[c] = sh.smoke[c] * sh.smokeAlpha + sh.flame[c];
+                    }
+                    cell[3] = sh.smokeAlpha;
+                }
             }
+        });
+
+        // Column taps are identical for every row.
+        std::vector<int> colX0(width_);
+        std::vector<float> colT(width_);
+        float scaleX = (float)shadeWidth_ / (float)width_;
+        float scaleY = (float)shadeHeight_ / (float)height_;
+        for (int x = 0; x < width_; ++x) {
+            float fx = std::clamp(((float)x + 0.5f) * scaleX - 0.5f, 0.0f, (float)(shadeWidth_ - 1));
+            colX0[x] = std::min((int)fx, std::max(0, shadeWidth_ - 2));
+            colT[x] = fx - colX0[x];
         }
+        const int stepX = (shadeWidth_ > 1) ? 4 : 0;
+
+        parallelRows(0, height_, [&](int yBegin, int yEnd) {
+            for (int y = yBegin; y < yEnd; ++y) {
+                float fy = std::clamp(((float)y + 0.5f) * scaleY - 0.5f, 0.0f, (float)(shadeHeight_ - 1));
+                int y0 = std::min((int)fy, std::max(0, shadeHeight_ - 2));
+                int y1 = std::min(y0 + 1, shadeHeight_ - 1);
+                float ty = fy - y0;
+                const float* r0 = &shadeRGBA_[(size_t)y0 * shadeWidth_ * 4];
+                const float* r1 = &shadeRGBA_[(size_t)y1 * shadeWidth_ * 4];
+                uint8_t* out = &frame[(size_t)y * width_ * 3];
+                for (int x = 0; x < width_; ++x) {
+                    const float* a0 = r0 + colX0[x] * 4;
+                    const float* a1 = r1 + colX0[x] * 4;
+                    float tx = colT[x];
+                    float rgba[4];
+                    for (int c = 0; c < 4; ++c) {
+                        float top = a0[c] + (a0[c + stepX] - a0[c]) * tx;
+                        float bot = a1[c] + (a1[c + stepX] - a1[c]) * tx;
+                        rgba[c] = top + (bot - top) * ty;
+                    }
+                    if (rgba[3] <= 0.0f && rgba[0] <= 0.0f && rgba[1] <= 0.0f && rgba[2] <= 0.0f) continue;
+                    compositeShadeCell(out + x * 3, rgba);
+                }
+            }
+        });
+    }
+
+    void setSeed(uint32_t seed) override {
+        rng_.seed(seed);
     }
 
     void update() override {
@@ -375,6 +375,15 @@ public:
         }
     }
     
+    std::unique_ptr<Effect> cloneForRender() const override {
+        // renderFrame only reads state, so a copy can render this frame.
+        return std::make_unique<LaserEffect>(*this);
+    }
+
+    void setSeed(uint32_t seed) override {
+        rng_.seed(seed);
+    }
+
     void update() override {
         updateRays();
         updateFocalPoint();
@@ -16,8 +16,9 @@ private:
     int expectedTotalFrames_;
     float globalWarmupSeconds_;
     
-    // Storage for the beginning frames (offset by crossfade duration)
-    std::vector<std::vector<uint8_t>> beginningFrames_;
+    // Storage for the beginning frames (offset by crossfade duration). These
+    // share pixels with the pipeline frames they were captured from.
+    std::vector<FrameBuffer> beginningFrames_;
     bool capturedBeginning_;
     
 public:
@@ -63,11 +64,8 @@ public:
         currentFrame_ = -warmupFrames;
         capturedBeginning_ = false;
         
-        // Pre-allocate storage for beginning frames
-        beginningFrames_.resize(crossfadeFrames_);
-        for (auto& frame : beginningFrames_) {
-            frame.resize(width * height * 3);
-        }
+        // Until captured, every beginning frame is the same black frame
+        beginningFrames_.assign(crossfadeFrames_, FrameBuffer(std::vector<uint8_t>((size_t)width * height * 3, 0)));
         
         std::cerr << "Loop fade: " << crossfadeFrames_ << " frames (" 
                   << crossfadeDuration_ << "s) crossfade\n";        
@@ -77,8 +75,19 @@ public:
     void setGlobalWarmupSeconds(float seconds) override {
         globalWarmupSeconds_ = std::max(0.0f, seconds);
     }
+
+    // The crossfade blends the timeline's first frames into its last ones.
+    bool supportsFrameRange() const override {
+        return false;
+    }
     
     void renderFrame(std::vector<uint8_t>& frame, bool hasBackground, float fadeMultiplier) override {
+        FrameBuffer shared(frame);
+        renderFrameBuffer(shared, hasBackground, fadeMultiplier);
+    }
+
+    // Capturing only reads the frame, so keep a handle instead of copying it.
+    void renderFrameBuffer(FrameBuffer& frame, bool hasBackground, float fadeMultiplier) override {
         if (!hasBackground) {
             std::cerr << "ERROR: loopfade effect requires --background-video\n";
             return;
@@ -87,8 +96,8 @@ public:
         // Capture frames from start
         if (currentFrame_ < crossfadeFrames_) {
             int storeIdx = currentFrame_;
-            if (storeIdx < (int)beginningFrames_.size()) {
-                std::copy(frame.begin(), frame.end(), beginningFrames_[storeIdx].begin());
+            if (storeIdx >= 0 && storeIdx < (int)beginningFrames_.size()) {
+                beginningFrames_[storeIdx] = frame;
                 if (!capturedBeginning_ && storeIdx == 0) {
                     std::cerr << "Capturing beginning frames for crossfade...\n";
                     capturedBeginning_ = true;
@@ -102,6 +111,20 @@ public:
     }
     
     void postProcess(std::vector<uint8_t>& frame, int frameIndex, int totalFrames, bool& dropFrame) override {
+        int fadeFrameIdx = crossfadeIndex(frameIndex, totalFrames, dropFrame);
+        if (fadeFrameIdx >= 0) blend(frame, fadeFrameIdx, frameIndex);
+    }
+
+    // Frames outside the crossfade zone pass through without being written.
+    void postProcessFrameBuffer(FrameBuffer& frame, int frameIndex, int totalFrames, bool& dropFrame) override {
+        int fadeFrameIdx = crossfadeIndex(frameIndex, totalFrames, dropFrame);
+        if (fadeFrameIdx >= 0) blend(frame.write(), fadeFrameIdx, frameIndex);
+    }
+
+private:
+    // Returns the beginning frame to blend with, or -1 if the frame is
+    // outside the crossfade zone.
+    int crossfadeIndex(int frameIndex, int totalFrames, bool& dropFrame) {
         // Do not drop frames by default
         dropFrame = false;
 
@@ -115,7 +138,7 @@ public:
         if(frameIndex <= crossfadeFrames_) {
             // Drop the initial frames 
             dropFrame = true;
-            return;
+            return -1;
         }
 
         // Calculate if we're in the crossfade zone
@@ -123,29 +146,33 @@ public:
         
         if (frameIndex >= fadeStartFrame && frameIndex < totalFrames) {
             int fadeFrameIdx = frameIndex - fadeStartFrame;
-            
             if (fadeFrameIdx >= 0 && fadeFrameIdx < (int)beginningFrames_.size()) {
-                // Calculate crossfade alpha (0.0 at start of fade, 1.0 at end)
-                float alpha = (float)(fadeFrameIdx + 1) / (float)crossfadeFrames_;
-                
-                const auto& beginFrame = beginningFrames_[fadeFrameIdx];
-                
-                // Crossfade: blend current frame with beginning frame
-                for (size_t i = 0; i < frame.size(); i++) {
-                    float current = frame[i] / 255.0f;
-                    float begin = beginFrame[i] / 255.0f;
-                    
-                    // Linear crossfade
-                    float result = current * (1.0f - alpha) + begin * alpha;
-                    frame[i] = (uint8_t)(std::clamp(result, 0.0f, 1.0f) * 255);
-                }
-                
-                // Debug: print when crossfade starts
-                if (fadeFrameIdx == 0) {
-                    std::cerr << "Starting crossfade at frame " << frameIndex << "...\n";
-                }
+                return fadeFrameIdx;
             }
         }
+        return -1;
+    }
+
+    void blend(std::vector<uint8_t>& frame, int fadeFrameIdx, int frameIndex) {
+        // Calculate crossfade alpha (0.0 at start of fade, 1.0 at end)
+        float alpha = (float)(fadeFrameIdx + 1) / (float)crossfadeFrames_;
+        
+        const auto& beginFrame = beginningFrames_[fadeFrameIdx].read();
+        
+        // Crossfade: blend current frame with beginning frame
+        for (size_t i = 0; i < frame.size(); i++) {
+            float current = frame[i] / 255.0f;
+            float begin = beginFrame[i] / 255.0f;
+            
+            // Linear crossfade
+            float result = current * (1.0f - alpha) + begin * alpha;
+            frame[i] = (uint8_t)(std::clamp(result, 0.0f, 1.0f) * 255);
+        }
+        
+        // Debug: print when crossfade starts
+        if (fadeFrameIdx == 0) {
+            std::cerr << "Starting crossfade at frame " << frameIndex << "...\n";
+        }
     }
 };
 
@@ -3,12 +3,21 @@
 
 #include "effect_generator.h"
 #include "json_util.h"
+#include "autotune.h"
+#include "estimate.h"
+#include "metrics.h"
+#include "segment_job.h"
 #include <iostream>
 #include <string>
 #include <sstream>
 #include <cstdlib>
 #include <vector>
 #include <unordered_map>
+#include <filesystem>
+#include <random>
+#include <climits>
+#include <cmath>
+#include <thread>
 
 template <typename Options>
 void printHelp(const Options& opts) {
@@ -59,11 +68,21 @@ void printHelp(const Options& opts) {
     }
 }
 
+struct AppliedOption {
+    std::string name;
+    std::string value;
+    bool hasValue = false;
+};
+
 struct EffectInvocation {
     std::string name;
     std::unique_ptr<Effect> effect;
     float maxFadeRatio = 1.0f;
     bool hasMaxFadeOverride = false;
+    StageWindow window;
+    // Options in the order given, so fresh instances can be configured
+    // identically (used by --autotune probes and as the tuning cache key).
+    std::vector<AppliedOption> options;
 };
 
 using EffectOptionMap = std::unordered_map<std::string, Effect::EffectOption>;
@@ -94,6 +113,117 @@ bool applyEffectOption(Effect& effect, const std::string& option, const std::str
     return true;
 }
 
+std::string stageSignature(const EffectInvocation& stage) {
+    std::string sig = stage.name;
+    for (const auto& opt : stage.options) {
+        sig += " " + opt.name;
+        if (opt.hasValue) sig += " " + opt.value;
+    }
+    return sig;
+}
+
+std::unique_ptr<Effect> createConfiguredEffect(const EffectInvocation& stage) {
+    auto effect = EffectFactory::instance().create(stage.name);
+    if (!effect) return nullptr;
+    for (const auto& opt : stage.options) {
+        if (!applyEffectOption(*effect, opt.name, opt.hasValue ? &opt.value : nullptr)) return nullptr;
+    }
+    return effect;
+}
+
+// Benchmark worker counts for every stage that supports them and store the
+// winners in the tuning cache. Returns false only if the cache can't be saved.
+bool runAutotune(std::vector<EffectInvocation>& stages, int width, int height, int fps,
+                 bool hasBackground, autotune::TuningCache& cache) {
+    const autotune::ProbeWindow probeWindow;
+    auto candidates = autotune::threadCandidates();
+    std::cerr << "Autotune: " << autotune::hostKey() << ", " << width << "x" << height << "\n";
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const auto& stage = stages[i];
+        // Effects log their setup on stderr; keep probe output quiet.
+        std::ostringstream sink;
+        auto oldbuf = std::cerr.rdbuf(sink.rdbuf());
+        int best = autotune::benchmarkWorkerThreads(
+            [&]() { return createConfiguredEffect(stage); },
+            width, height, fps, hasBackground || i > 0, candidates, probeWindow);
+        std::cerr.rdbuf(oldbuf);
+        if (best <= 0) {
+            std::cerr << "Autotune: stage " << (i + 1) << " (" << stage.name << ") has no tunable workers\n";
+            continue;
+        }
+        std::cerr << "Autotune: stage " << (i + 1) << " (" << stage.name << ") threads=" << best << "\n";
+        cache.store(autotune::stageKey(width, height, (int)i, stageSignature(stage)), best);
+    }
+    if (!cache.save()) {
+        std::cerr << "Error: Could not write tuning cache '" << cache.path() << "'\n";
+        return false;
+    }
+    std::cerr << "Autotune: results saved to " << cache.path() << "\n";
+    return true;
+}
+
+// Probe every stage on this host and print the predicted cost of the render
+// described by the command line.
+bool runEstimate(std::vector<EffectInvocation>& stages, int width, int height, int fps,
+                 int totalFrames, float warmupSeconds, int frameWorkers, bool hasBackground, bool readAhead) {
+    estimate::PipelineShape shape;
+    shape.width = width;
+    shape.height = height;
+    shape.fps = fps;
+    shape.frames = totalFrames;
+    shape.warmupFrames = (int)std::round(std::max(0.0f, warmupSeconds) * fps);
+    shape.frameWorkers = frameWorkers > 0 ? frameWorkers : std::max(1, (int)std::thread::hardware_concurrency());
+    shape.readAhead = readAhead;
+
+    long long baseBytes = metrics::residentBytes();
+    std::vector<estimate::StageCost> costs;
+    for (size_t i = 0; i < stages.size(); ++i) {
+        Effect& effect = *stages[i].effect;
+        if (totalFrames > 0) effect.setTotalFrames(totalFrames);
+        effect.setGlobalWarmupSeconds(std::max(0.0f, warmupSeconds));
+        // Effects log their setup on stderr; keep probe output quiet.
+        std::ostringstream sink;
+        auto oldbuf = std::cerr.rdbuf(sink.rdbuf());
+        bool ok = effect.initialize(width, height, fps);
+        if (ok) {
+            costs.push_back(estimate::probeStage(effect, width, height, fps, hasBackground || i > 0,
+                                                 totalFrames > 0 ? totalFrames : INT_MAX));
+        }
+        std::cerr.rdbuf(oldbuf);
+        if (!ok) {
+            std::cerr << "Error: Failed to initialize effect stage " << (i + 1)
+                      << " (" << stages[i].name << ") for --estimate\n";
+            return false;
+        }
+        shape.frameParallel.push_back(shape.frameWorkers > 1 && effect.cloneForRender() != nullptr);
+
+        // Fraction of the timeline inside the stage's --start/--end window.
+        double active = 1.0;
+        if (totalFrames > 0) {
+            double length = (double)totalFrames / fps;
+            double start = std::min<double>(length, stages[i].window.startSec);
+            double end = stages[i].window.endSec >= 0.0f ? std::min<double>(length, stages[i].window.endSec) : length;
+            active = std::max(0.0, end - start) / length;
+        }
+        shape.activeFraction.push_back(active);
+    }
+    long long effectBytes = baseBytes >= 0 ? metrics::residentBytes() - baseBytes : -1;
+
+    estimate::Prediction prediction = estimate::predict(costs, shape, baseBytes, effectBytes);
+    estimate::printReport(std::cout, costs, shape, prediction);
+    return true;
+}
+
+// Apply cached tuning results to the pipeline stages. Stages without an
+// entry for this host/resolution keep their built-in defaults.
+void applyTuningCache(std::vector<EffectInvocation>& stages, int width, int height,
+                      const autotune::TuningCache& cache) {
+    for (size_t i = 0; i < stages.size(); ++i) {
+        int threads = cache.lookup(autotune::stageKey(width, height, (int)i, stageSignature(stages[i])));
+        if (threads > 0) stages[i].effect->setWorkerThreads(threads);
+    }
+}
+
 void printUsage(const char* prog) {
     std::cout << "Effect Generator " << getEffectGeneratorVersion() << " - Video Effects Tool\n";
     std::cout << "Find the latest version at https://github.com/fiforms/effectgenerator\n";
@@ -106,12 +236,34 @@ void printUsage(const char* prog) {
     std::cout << "  --effect <name>           Add an effect stage (required; repeatable, order-sensitive)\n";
     std::cout << "  --help-<effectname>       Show help for specific effect\n";
     std::cout << "  --version                 Show program version\n\n";
-    std::cout << "  --show                    Print resolved effect configuration and exit\n\n";
+    std::cout << "  --show                    Print resolved effect configuration and exit\n";
+    std::cout << "  --estimate                Probe each stage briefly on this host and print predicted frames/s,\n";
+    std::cout << "                            wall time, peak memory and the bottleneck stage, then exit\n";
+    std::cout << "  --autotune                Benchmark worker counts for this host, resolution and effect chain,\n";
+    std::cout << "                            save them to the tuning cache, then render (or exit if no --output)\n";
+    std::cout << "  --stats                   Report per-stage timings and hardware counters (Linux perf) when done\n";
+    std::cout << "  --metrics-listen <addr>   Serve Prometheus metrics while rendering; <addr> is a loopback\n";
+    std::cout << "                            port (9464, 127.0.0.1:9464) or unix:/path/to/socket\n";
+    std::cout << "  --frame-workers <int>     Frames rendered concurrently in stages that allow it\n";
+    std::cout << "                            (0 = hardware threads, 1 = off; default: 0)\n";
+    std::cout << "  --seed <int>              Seed effect randomness for reproducible output (stage N uses seed+N-1)\n\n";
+    std::cout << "Segmented Rendering:\n";
+    std::cout << "  --coordinate <dir>        Split the job into segments published in <dir> (a shared directory),\n";
+    std::cout << "                            render what this process can claim, then join the results into --output\n";
+    std::cout << "  --segments <int>          Number of segments for --coordinate\n";
+    std::cout << "  --segment-warmup <float>  Extra warmup seconds for segments after the first (default: 10.0);\n";
+    std::cout << "                            with --frame-range, extra warmup before the range\n";
+    std::cout << "  --worker <dir>            Claim and render segments from a job directory (use as the only option)\n";
+    std::cout << "  --frame-range <first>:<count>  Render only these frames of the --duration timeline\n\n";
     std::cout << "Global Effect Options:\n";
     std::cout << "  --warmup <float>          Pre-run simulation time in seconds before first output frame (default: 0.0)\n";
     std::cout << "  --fade <float>            Fade in/out duration in seconds (default: 0.0)\n";
     std::cout << "  --max-fade <float>        Maximum opacity (0.0-1.0) for the current effect stage\n";
-    std::cout << "                            If provided before any --effect, it sets the default for all stages (default: 1.0)\n\n";
+    std::cout << "                            If provided before any --effect, it sets the default for all stages (default: 1.0)\n";
+    std::cout << "  --start <float>           Time in seconds at which the current effect stage starts (default: 0.0)\n";
+    std::cout << "  --end <float>             Time in seconds at which the current effect stage stops (default: end of video)\n";
+    std::cout << "  --ramp <float>            Fade the current stage in/out over this many seconds at --start/--end (default: 0.0)\n";
+    std::cout << "                            Outside its window a stage passes frames through and its simulation pauses\n\n";
     std::cout << "Video Options:\n";
     std::cout << "  --width <int>             Video width (default: 1920)\n";
     std::cout << "  --height <int>            Video height (default: 1080)\n";
@@ -119,7 +271,10 @@ void printUsage(const char* prog) {
     std::cout << "  --duration <int>          Duration in seconds (default: 5)\n";
     std::cout << "  --background-image <path> Background image (JPG/PNG)\n";
     std::cout << "  --background-video <path> Background video (MP4/MOV/etc), or '-' for stdin rawvideo\n";
-    std::cout << "  --crf <int>               Output video quality (default: 23, lower is better)\n\n";
+    std::cout << "  --crf <int>               Output video quality (default: 23, lower is better)\n";
+    std::cout << "  --encoder-speed <preset>  Encoder preset for MP4/MKV (libx264) or WebM (SVT-AV1) output, or 'auto' to\n";
+    std::cout << "                            calibrate preset and encoder threads so encoding keeps pace with rendering\n";
+    std::cout << "                            (default: medium / 7)\n\n";
     std::cout << "Audio Options:\n";
     std::cout << "  --audio-codec <string>    Output Audio Codec (passed to ffmpeg, default none)\n";
     std::cout << "  --audio-bitrate <int>     Audio Bitrate in kbps (default: 192)\n";
@@ -130,7 +285,8 @@ void printUsage(const char* prog) {
     std::cout << "  --background-video -      stdin must be rawvideo rgb24 at --width x --height and --fps\n";
     std::cout << "  --output -                stdout is rawvideo rgb24 at --width x --height and --fps\n\n";
     std::cout << "Environment Variables:\n";
-    std::cout << "  FFMPEG_PATH               Path to ffmpeg executable\n\n";
+    std::cout << "  FFMPEG_PATH               Path to ffmpeg executable\n";
+    std::cout << "  EFFECTGENERATOR_TUNE_CACHE  Tuning cache file (default: ~/.cache/effectgenerator/tuning.cache)\n\n";
     std::cout << "Examples:\n";
     std::cout << "  " << prog << " --list-effects\n";
     std::cout << "  " << prog << " --help-snowflake\n";
@@ -209,7 +365,120 @@ void listEffectsJson() {
     std::cout << root.toString() << std::endl;
 }
 
+int runGenerator(int argc, char** argv);
+
+// Run the generator in-process with `args` (excluding argv[0]); used to
+// render segments claimed from a job directory.
+int runWithArgs(const std::vector<std::string>& args) {
+    std::vector<std::string> storage;
+    storage.push_back("effectgenerator");
+    storage.insert(storage.end(), args.begin(), args.end());
+    std::vector<char*> argvPtrs;
+    for (auto& token : storage) argvPtrs.push_back(token.data());
+    argvPtrs.push_back(nullptr);
+    return runGenerator((int)storage.size(), argvPtrs.data());
+}
+
+struct CoordinatorSettings {
+    std::string jobDir;
+    int segments = 0;
+    float segmentWarmup = 10.0f;
+    bool hasSegmentWarmup = false;  // given explicitly; a --frame-range run only pre-rolls then
+    std::vector<std::string> jobArgs;  // arguments shared by every segment
+};
+
+// Split the timeline into segments, publish them as work items, render as
+// many as this process can claim, wait for the rest, then join them.
+int runCoordinator(const CoordinatorSettings& settings, int width, int height, int fps, int duration,
+                   float warmupDuration, bool hasSeed, uint32_t seed, int crf,
+                   const std::string& output, bool overwriteOutput) {
+    if (duration <= 0) {
+        std::cerr << "Error: --coordinate requires an explicit --duration\n";
+        return 1;
+    }
+    if (output.empty() || output == "-") {
+        std::cerr << "Error: --coordinate requires an --output file\n";
+        return 1;
+    }
+    std::string extension = std::filesystem::path(output).extension().string();
+    if (extension.empty()) {
+        std::cerr << "Error: --output needs a file extension so segments use the same container\n";
+        return 1;
+    }
+    if (!overwriteOutput) {
+        if (FILE* file = std::fopen(output.c_str(), "rb")) {
+            std::fclose(file);
+            std::cerr << "Error: Output file '" << output << "' already exists. Please choose a different name or pass --overwrite.\n";
+            return 1;
+        }
+    }
+
+    int totalFrames = fps * duration;
+    int segments = std::max(1, std::min(settings.segments, totalFrames));
+    if (!hasSeed) {
+        // Resuming without --seed: reuse the seed the job was published with.
+        if (segmentjob::readJobSeed(settings.jobDir, seed)) {
+            std::cerr << "Coordinator: reusing job seed from " << settings.jobDir << "\n";
+        } else {
+            seed = std::random_device{}();
+        }
+    }
+    std::cerr << "Coordinator: " << totalFrames << " frames in " << segments << " segments, job seed "
+              << seed << ", job directory " << settings.jobDir << "\n";
+
+    std::vector<segmentjob::WorkItem> items;
+    for (int k = 0; k < segments; ++k) {
+        int first = (int)((long long)totalFrames * k / segments);
+        int next = (int)((long long)totalFrames * (k + 1) / segments);
+        segmentjob::WorkItem item;
+        item.index = k;
+        item.output = segmentjob::segmentPath(settings.jobDir, k, extension);
+        item.args = {
+            "--seed", std::to_string((uint32_t)(seed + (uint32_t)k * 1000003u)),
+            "--warmup", std::to_string(warmupDuration),
+            "--frame-range", std::to_string(first) + ":" + std::to_string(next - first)
+        };
+        // Later segments start from a fresh simulation, so give them extra
+        // warmup to reach the same steady state as a continuous render.
+        // It is passed separately so effects still see the job's --warmup.
+        if (k > 0) item.args.insert(item.args.end(), {"--segment-warmup", std::to_string(settings.segmentWarmup)});
+        item.args.insert(item.args.end(), settings.jobArgs.begin(), settings.jobArgs.end());
+        items.push_back(std::move(item));
+    }
+
+    if (!segmentjob::publish(settings.jobDir, items, seed)) return 1;
+    std::cerr << "Coordinator: work items published; start more workers with:\n"
+              << "  effectgenerator --worker " << settings.jobDir << "\n";
+
+    if (segmentjob::runWorker(settings.jobDir, runWithArgs) < 0) return 1;
+    if (!segmentjob::waitForSegments(settings.jobDir, items, runWithArgs)) return 1;
+
+    std::vector<std::string> files;
+    for (const auto& item : items) files.push_back(item.output);
+    VideoGenerator generator(width, height, fps, 0.0f, 1.0f, crf);
+    if (!generator.concatenate(files, output.c_str())) {
+        std::cerr << "Error: Could not join segments; they remain in " << settings.jobDir << "\n";
+        return 1;
+    }
+    std::cout << "\nVideo saved to: " << output << " (" << segments << " segments)\n";
+    return 0;
+}
+
 int main(int argc, char** argv) {
+    if (argc >= 2 && std::string(argv[1]) == "--worker") {
+        if (argc != 3) {
+            std::cerr << "Usage: " << argv[0] << " --worker <job-directory>\n";
+            return 1;
+        }
+        int rendered = segmentjob::runWorker(argv[2], runWithArgs);
+        if (rendered < 0) return 1;
+        std::cerr << "Worker: rendered " << rendered << " segment(s); no unclaimed work left in " << argv[2] << "\n";
+        return 0;
+    }
+    return runGenerator(argc, argv);
+}
+
+int runGenerator(int argc, char** argv) {
     // Check for help or list
     if (argc == 1) {
         printUsage(argv[0]);
@@ -301,11 +570,24 @@ int main(int argc, char** argv) {
     // Parse common arguments
     int width = 1920, height = 1080, fps = 30, duration = -1; // -1 means auto-detect
     int crf = 23;
+    std::string encoderSpeed;
     float warmupDuration = 0.0f;
     float fadeDuration = 0.0f;
     float defaultMaxFadeRatio = 1.0f;
     std::string output = "";
     bool showConfig = false;
+    bool estimateOnly = false;
+    bool runTuning = false;
+    bool collectStats = false;
+    std::string metricsListen;
+    int frameWorkers = 0;
+    bool hasSeed = false;
+    uint32_t seed = 0;
+    int rangeFirst = 0;
+    int rangeCount = -1;
+    CoordinatorSettings coordinator;
+    // Arguments that are not replayed into segment work items.
+    std::vector<bool> segmentLocalArg((size_t)argc, false);
     bool overwriteOutput = false;
     std::string backgroundImage;
     std::string backgroundVideo;
@@ -345,6 +627,18 @@ int main(int argc, char** argv) {
                 stages[currentStage].hasMaxFadeOverride = true;
                 continue;
             }
+            if (arg == "--start" && i + 1 < argc) {
+                stages[currentStage].window.startSec = std::atof(argv[++i]);
+                continue;
+            }
+            if (arg == "--end" && i + 1 < argc) {
+                stages[currentStage].window.endSec = std::atof(argv[++i]);
+                continue;
+            }
+            if (arg == "--ramp" && i + 1 < argc) {
+                stages[currentStage].window.rampSec = std::atof(argv[++i]);
+                continue;
+            }
 
             auto optIt = stageOptionMaps[currentStage].find(arg);
             if (optIt != stageOptionMaps[currentStage].end()) {
@@ -378,6 +672,7 @@ int main(int argc, char** argv) {
                               << " (" << stages[currentStage].name << ")\n";
                     return 1;
                 }
+                stages[currentStage].options.push_back({arg, value, valuePtr != nullptr});
                 continue;
             }
         }
@@ -391,6 +686,7 @@ int main(int argc, char** argv) {
         } else if (arg == "--duration" && i + 1 < argc) {
             duration = std::atoi(argv[++i]);
         } else if (arg == "--warmup" && i + 1 < argc) {
+            segmentLocalArg[i] = segmentLocalArg[i + 1] = true;
             warmupDuration = std::atof(argv[++i]);
         } else if (arg == "--fade" && i + 1 < argc) {
             fadeDuration = std::atof(argv[++i]);
@@ -398,16 +694,56 @@ int main(int argc, char** argv) {
             defaultMaxFadeRatio = std::atof(argv[++i]);
         } else if (arg == "--crf" && i + 1 < argc) {
             crf = std::atoi(argv[++i]);
+        } else if (arg == "--encoder-speed" && i + 1 < argc) {
+            encoderSpeed = argv[++i];
         } else if (arg == "--audio-codec" && i + 1 < argc) {
             audioCodec = argv[++i];
         } else if (arg == "--audio-bitrate" && i + 1 < argc) {
             audioBitrate = argv[++i];
         } else if (arg == "--output" && i + 1 < argc) {
+            segmentLocalArg[i] = segmentLocalArg[i + 1] = true;
             output = argv[++i];
         } else if (arg == "--show") {
             showConfig = true;
+        } else if (arg == "--estimate") {
+            estimateOnly = true;
+        } else if (arg == "--autotune") {
+            segmentLocalArg[i] = true;
+            runTuning = true;
+        } else if (arg == "--stats") {
+            collectStats = true;
+        } else if (arg == "--metrics-listen" && i + 1 < argc) {
+            segmentLocalArg[i] = segmentLocalArg[i + 1] = true;
+            metricsListen = argv[++i];
         } else if (arg == "--overwrite") {
+            segmentLocalArg[i] = true;
             overwriteOutput = true;
+        } else if (arg == "--frame-workers" && i + 1 < argc) {
+            frameWorkers = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            segmentLocalArg[i] = segmentLocalArg[i + 1] = true;
+            seed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+            hasSeed = true;
+        } else if (arg == "--frame-range" && i + 1 < argc) {
+            segmentLocalArg[i] = segmentLocalArg[i + 1] = true;
+            std::string range = argv[++i];
+            size_t colon = range.find(':');
+            rangeFirst = std::atoi(range.substr(0, colon).c_str());
+            rangeCount = colon == std::string::npos ? -1 : std::atoi(range.c_str() + colon + 1);
+            if (rangeFirst < 0 || rangeCount <= 0) {
+                std::cerr << "Error: --frame-range expects <first>:<count>\n";
+                return 1;
+            }
+        } else if (arg == "--coordinate" && i + 1 < argc) {
+            segmentLocalArg[i] = segmentLocalArg[i + 1] = true;
+            coordinator.jobDir = argv[++i];
+        } else if (arg == "--segments" && i + 1 < argc) {
+            segmentLocalArg[i] = segmentLocalArg[i + 1] = true;
+            coordinator.segments = std::atoi(argv[++i]);
+        } else if (arg == "--segment-warmup" && i + 1 < argc) {
+            segmentLocalArg[i] = segmentLocalArg[i + 1] = true;
+            coordinator.segmentWarmup = std::max(0.0f, (float)std::atof(argv[++i]));
+            coordinator.hasSegmentWarmup = true;
         } else if (arg == "--background-image" && i + 1 < argc) {
             backgroundImage = argv[++i];
         } else if ((arg == "--background-video") && i + 1 < argc) {
@@ -428,6 +764,68 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    if (!output.empty() && !VideoGenerator::checkEncoderSpeed(encoderSpeed, output.c_str())) {
+        return 1;
+    }
+
+    if (!coordinator.jobDir.empty()) {
+        if (coordinator.segments <= 0) {
+            std::cerr << "Error: --coordinate requires --segments <count>\n";
+            return 1;
+        }
+        if (!backgroundVideo.empty() || rangeCount > 0 || showConfig || estimateOnly) {
+            std::cerr << "Error: --coordinate cannot be combined with --background-video, --frame-range, --show or --estimate\n";
+            return 1;
+        }
+        // Segments are rendered as frame ranges; refuse effects that cannot
+        // be split before publishing anything.
+        for (size_t i = 0; i < stages.size(); ++i) {
+            stages[i].effect->setGlobalWarmupSeconds(std::max(0.0f, warmupDuration));
+            if (!stages[i].effect->supportsFrameRange()) {
+                std::cerr << "Error: Effect stage " << (i + 1) << " (" << stages[i].effect->getName()
+                          << ") depends on the whole timeline with these settings and cannot be split into segments\n";
+                return 1;
+            }
+        }
+        for (int i = 1; i < argc; ++i) {
+            if (!segmentLocalArg[i]) coordinator.jobArgs.push_back(argv[i]);
+        }
+        return runCoordinator(coordinator, width, height, fps, duration, warmupDuration,
+                              hasSeed, seed, crf, output, overwriteOutput);
+    }
+
+    if (hasSeed) {
+        // Offset per stage so repeated effects don't move in lockstep.
+        for (size_t i = 0; i < stages.size(); ++i) {
+            stages[i].effect->setSeed(seed + (uint32_t)i);
+        }
+    }
+
+    autotune::TuningCache tuningCache(autotune::defaultCachePath());
+    tuningCache.load();
+    if (runTuning) {
+        bool probeBackground = !backgroundImage.empty() || !backgroundVideo.empty();
+        if (!runAutotune(stages, width, height, fps, probeBackground, tuningCache)) {
+            return 1;
+        }
+        if (output.empty() && !showConfig) return 0;
+    }
+    applyTuningCache(stages, width, height, tuningCache);
+
+    if (estimateOnly) {
+        // Same duration rules as a real run; an auto-detected duration
+        // leaves the frame count unknown.
+        int estimateFrames = -1;
+        if (duration > 0) estimateFrames = fps * duration;
+        else if (backgroundVideo.empty()) estimateFrames = fps * 5;
+        if (estimateFrames > 0 && rangeCount > 0) {
+            estimateFrames = std::max(0, std::min(rangeCount, estimateFrames - rangeFirst));
+        }
+        bool hasBackground = !backgroundImage.empty() || !backgroundVideo.empty();
+        return runEstimate(stages, width, height, fps, estimateFrames, warmupDuration, frameWorkers,
+                           hasBackground, !backgroundVideo.empty()) ? 0 : 1;
+    }
+
     if (showConfig) {
         std::cout << "Effect pipeline configuration (resolved):\n";
         std::cout << "Resolution: " << width << "x" << height << "\n";
@@ -441,6 +839,12 @@ int main(int argc, char** argv) {
             }
             std::cout << "\nStage " << (i + 1) << ": " << stage.effect->getName() << "\n";
             std::cout << "Max fade ratio: " << stage.maxFadeRatio << "\n";
+            if (!stage.window.isDefault()) {
+                std::cout << "Active window: " << stage.window.startSec << "s to ";
+                if (stage.window.endSec >= 0.0f) std::cout << stage.window.endSec << "s";
+                else std::cout << "end";
+                std::cout << " (ramp " << stage.window.rampSec << "s)\n";
+            }
             stage.effect->printConfig(std::cout);
         }
         return 0;
@@ -464,10 +868,31 @@ int main(int argc, char** argv) {
         std::cerr << "Error: Cannot specify both --background-image and --background-video\n";
         return 1;
     }
+    if (rangeCount > 0 && !backgroundVideo.empty()) {
+        std::cerr << "Error: --frame-range cannot be combined with --background-video\n";
+        return 1;
+    }
     
     // Create video generator (pass CLI CRF through)
     VideoGenerator generator(width, height, fps, fadeDuration, defaultMaxFadeRatio, crf, audioCodec, audioBitrate);
     generator.setWarmupSeconds(warmupDuration);
+    generator.setCollectStats(collectStats);
+    if (rangeCount > 0) {
+        generator.setFrameRange(rangeFirst, rangeCount);
+        if (coordinator.hasSegmentWarmup) generator.setPrerollSeconds(coordinator.segmentWarmup);
+    }
+    generator.setFrameWorkers(frameWorkers);
+    generator.setEncoderSpeed(encoderSpeed);
+
+    metrics::PipelineMetrics pipelineMetrics;
+    metrics::MetricsServer metricsServer(pipelineMetrics);
+    if (!metricsListen.empty()) {
+        if (!metricsServer.start(metricsListen)) {
+            return 1;
+        }
+        std::cerr << "Serving metrics on " << metricsServer.address() << " (GET /metrics)\n";
+        generator.setMetrics(&pipelineMetrics);
+    }
     
     // Set background if specified
     if (!backgroundImage.empty()) {
@@ -528,16 +953,22 @@ int main(int argc, char** argv) {
     if (!backgroundVideo.empty()) {
         infoOut << "Background video: " << backgroundVideo << "\n";
     }
+    if (!encoderSpeed.empty()) {
+        infoOut << "Encoder speed: " << encoderSpeed << "\n";
+    }
     infoOut << "Output: " << output << "\n\n";
     
     std::vector<Effect*> pipeline;
     std::vector<float> stageMaxFadeRatios;
+    std::vector<StageWindow> stageWindows;
     pipeline.reserve(stages.size());
     stageMaxFadeRatios.reserve(stages.size());
     for (auto& stage : stages) {
         pipeline.push_back(stage.effect.get());
         stageMaxFadeRatios.push_back(stage.maxFadeRatio);
+        stageWindows.push_back(stage.window);
     }
+    generator.setStageWindows(stageWindows);
 
     // Generate video
     if (!generator.generate(pipeline, stageMaxFadeRatios, duration, output.c_str())) {
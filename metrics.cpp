@@ -0,0 +1,407 @@
+// metrics.cpp
+// Live pipeline metrics and a local Prometheus text-format listener.
+
+#include "metrics.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifndef _WIN32
+    #include <arpa/inet.h>
+    #include <netinet/in.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/time.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+namespace metrics {
+
+namespace {
+
+#if defined(MSG_NOSIGNAL)
+const int kSendFlags = MSG_NOSIGNAL;
+#else
+const int kSendFlags = 0;
+#endif
+
+// The listener serves one client at a time, so a client that stalls while
+// sending its request or reading the response is cut off after this long.
+const int kClientTimeoutMs = 2000;
+
+std::string escapeLabel(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '\\' || c == '"') out += '\\';
+        if (c == '\n') { out += "\\n"; continue; }
+        out += c;
+    }
+    return out;
+}
+
+} // namespace
+
+long long residentBytes() {
+#ifdef __linux__
+    std::ifstream in("/proc/self/statm");
+    long long sizePages = 0, residentPages = 0;
+    if (in >> sizePages >> residentPages) {
+        return residentPages * (long long)sysconf(_SC_PAGESIZE);
+    }
+#endif
+    return -1;
+}
+
+void PipelineMetrics::beginRun(const std::vector<std::string>& stageNames, int totalFrames, size_t queueCapacity,
+                               int workers) {
+    std::lock_guard<std::mutex> lock(mu_);
+    stages_.clear();
+    for (const auto& name : stageNames) {
+        auto s = std::make_unique<StageGauges>();
+        s->name = name;
+        stages_.push_back(std::move(s));
+    }
+    totalFrames_ = totalFrames;
+    queueCapacity_ = queueCapacity;
+    workers_ = std::max(1, workers);
+    framesWritten_.store(0);
+    writeNanos_.store(0);
+    writeStartNanos_.store(0);
+    start_ = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> windowLock(windowMu_);
+    windowStart_ = start_;
+    windowFrames_ = 0;
+    lastWindowFps_ = 0.0;
+    running_.store(true);
+}
+
+void PipelineMetrics::endRun() {
+    running_.store(false);
+    writeStartNanos_.store(0);
+}
+
+void PipelineMetrics::writeStarted() {
+    auto sinceStart = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_);
+    writeStartNanos_.store((uint64_t)sinceStart.count() + 1);
+}
+
+void PipelineMetrics::frameWritten(uint64_t writeNanos) {
+    writeStartNanos_.store(0);
+    uint64_t frames = framesWritten_.fetch_add(1) + 1;
+    writeNanos_.fetch_add(writeNanos);
+
+    // windowStart_ is only written on this thread, so reading it unlocked is safe.
+    auto now = std::chrono::steady_clock::now();
+    double window = std::chrono::duration<double>(now - windowStart_).count();
+    if (window >= 1.0) {
+        std::lock_guard<std::mutex> lock(windowMu_);
+        lastWindowFps_ = (double)(frames - windowFrames_) / window;
+        windowStart_ = now;
+        windowFrames_ = frames;
+    }
+}
+
+std::string PipelineMetrics::renderPrometheus() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    std::ostringstream os;
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - start_).count();
+    uint64_t written = framesWritten_.load();
+
+    // Rate over the last completed window, or over the open window once it
+    // has run past a second without a new frame (e.g. a stalled encoder).
+    double fps = 0.0;
+    if (running_.load()) {
+        std::lock_guard<std::mutex> windowLock(windowMu_);
+        double open = std::chrono::duration<double>(now - windowStart_).count();
+        fps = lastWindowFps_;
+        if (open > 1.0) fps = std::min(fps, (double)(written - windowFrames_) / open);
+    }
+
+    uint64_t writeStart = writeStartNanos_.load();
+    double writeInProgress = 0.0;
+    if (writeStart != 0) {
+        double startedAt = (double)(writeStart - 1) / 1e9;
+        writeInProgress = std::max(0.0, elapsed - startedAt);
+    }
+
+    os << "# HELP effectgenerator_running Whether a render is in progress.\n"
+       << "# TYPE effectgenerator_running gauge\n"
+       << "effectgenerator_running " << (running_.load() ? 1 : 0) << "\n";
+    os << "# HELP effectgenerator_frames_written_total Frames handed to the encoder.\n"
+       << "# TYPE effectgenerator_frames_written_total counter\n"
+       << "effectgenerator_frames_written_total " << written << "\n";
+    if (totalFrames_ > 0 && totalFrames_ != INT_MAX) {
+        os << "# HELP effectgenerator_frames_target Frames to render in this run.\n"
+           << "# TYPE effectgenerator_frames_target gauge\n"
+           << "effectgenerator_frames_target " << totalFrames_ << "\n";
+    }
+    os << "# HELP effectgenerator_fps Output frames per second over the last second.\n"
+       << "# TYPE effectgenerator_fps gauge\n"
+       << "effectgenerator_fps " << fps << "\n";
+    os << "# HELP effectgenerator_elapsed_seconds Wall time since the render started.\n"
+       << "# TYPE effectgenerator_elapsed_seconds gauge\n"
+       << "effectgenerator_elapsed_seconds " << elapsed << "\n";
+    if (running_.load() && fps > 0.0 && totalFrames_ > 0 && totalFrames_ != INT_MAX) {
+        double remaining = (double)totalFrames_ - (double)written;
+        os << "# HELP effectgenerator_eta_seconds Estimated time to completion at the current fps.\n"
+           << "# TYPE effectgenerator_eta_seconds gauge\n"
+           << "effectgenerator_eta_seconds " << (remaining > 0.0 ? remaining / fps : 0.0) << "\n";
+    }
+
+    double writeSeconds = (double)writeNanos_.load() / 1e9;
+    os << "# HELP effectgenerator_encoder_write_seconds_total Time the writer spent blocked handing frames to the encoder (completed writes).\n"
+       << "# TYPE effectgenerator_encoder_write_seconds_total counter\n"
+       << "effectgenerator_encoder_write_seconds_total " << writeSeconds << "\n";
+    os << "# HELP effectgenerator_encoder_write_in_progress_seconds How long the current write to the encoder has been blocked (0 when idle).\n"
+       << "# TYPE effectgenerator_encoder_write_in_progress_seconds gauge\n"
+       << "effectgenerator_encoder_write_in_progress_seconds " << writeInProgress << "\n";
+    os << "# HELP effectgenerator_encoder_backpressure_ratio Fraction of wall time spent blocked on the encoder, including the write in progress.\n"
+       << "# TYPE effectgenerator_encoder_backpressure_ratio gauge\n"
+       << "effectgenerator_encoder_backpressure_ratio "
+       << (elapsed > 0.0 ? std::min(1.0, (writeSeconds + writeInProgress) / elapsed) : 0.0) << "\n";
+
+    os << "# HELP effectgenerator_stage_frames_total Frames processed by each stage.\n"
+       << "# TYPE effectgenerator_stage_frames_total counter\n";
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        os << "effectgenerator_stage_frames_total{stage=\"" << (i + 1) << "\",effect=\""
+           << escapeLabel(stages_[i]->name) << "\"} " << stages_[i]->frames.load() << "\n";
+    }
+    os << "# HELP effectgenerator_stage_busy_seconds_total Time each stage spent in render/postprocess/update.\n"
+       << "# TYPE effectgenerator_stage_busy_seconds_total counter\n";
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        os << "effectgenerator_stage_busy_seconds_total{stage=\"" << (i + 1) << "\",effect=\""
+           << escapeLabel(stages_[i]->name) << "\"} " << (double)stages_[i]->busyNanos.load() / 1e9 << "\n";
+    }
+    os << "# HELP effectgenerator_stage_busy_ratio Share of the worker pool's capacity (workers x wall time) each stage used.\n"
+       << "# TYPE effectgenerator_stage_busy_ratio gauge\n";
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        double busy = (double)stages_[i]->busyNanos.load() / 1e9;
+        os << "effectgenerator_stage_busy_ratio{stage=\"" << (i + 1) << "\",effect=\""
+           << escapeLabel(stages_[i]->name) << "\"} " << (elapsed > 0.0 ? busy / (elapsed * workers_) : 0.0) << "\n";
+    }
+    os << "# HELP effectgenerator_workers Worker threads the pipeline stages share.\n"
+       << "# TYPE effectgenerator_workers gauge\n"
+       << "effectgenerator_workers " << workers_ << "\n";
+    os << "# HELP effectgenerator_queue_depth Frames each stage has finished that the next stage (or the writer) has not taken yet.\n"
+       << "# TYPE effectgenerator_queue_depth gauge\n";
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        os << "effectgenerator_queue_depth{stage=\"" << (i + 1) << "\",effect=\""
+           << escapeLabel(stages_[i]->name) << "\"} " << stages_[i]->queueDepth.load() << "\n";
+    }
+    os << "# HELP effectgenerator_queue_capacity Frames the scheduler allows in flight between stage 0 and the writer.\n"
+       << "# TYPE effectgenerator_queue_capacity gauge\n"
+       << "effectgenerator_queue_capacity " << queueCapacity_ << "\n";
+
+    long long rss = residentBytes();
+    if (rss >= 0) {
+        os << "# HELP effectgenerator_resident_memory_bytes Resident set size.\n"
+           << "# TYPE effectgenerator_resident_memory_bytes gauge\n"
+           << "effectgenerator_resident_memory_bytes " << rss << "\n";
+    }
+    return os.str();
+}
+
+#ifdef _WIN32
+
+bool MetricsServer::start(const std::string& /*spec*/) {
+    std::cerr << "Error: --metrics-listen is not supported on this platform\n";
+    return false;
+}
+
+void MetricsServer::stop() {}
+void MetricsServer::serveLoop() {}
+void MetricsServer::handleClient(int /*fd*/) {}
+
+#else
+
+bool MetricsServer::start(const std::string& spec) {
+    if (spec.rfind("unix:", 0) == 0) {
+        const std::string path = spec.substr(5);
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+            std::cerr << "Error: Invalid metrics socket path '" << path << "'\n";
+            return false;
+        }
+        std::memcpy(addr.sun_path, path.c_str(), path.size());
+        listenFd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd_ < 0) {
+            std::cerr << "Error: Could not create metrics socket\n";
+            return false;
+        }
+        // A stale socket from an earlier run would make bind fail. Only a
+        // socket nobody is listening on is removed; anything else at the
+        // path is left alone.
+        struct stat st;
+        if (lstat(path.c_str(), &st) == 0) {
+            if (!S_ISSOCK(st.st_mode)) {
+                std::cerr << "Error: Metrics socket path '" << path << "' exists and is not a socket\n";
+                close(listenFd_);
+                listenFd_ = -1;
+                return false;
+            }
+            int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+            bool live = probe >= 0 && connect(probe, (sockaddr*)&addr, sizeof(addr)) == 0;
+            if (probe >= 0) close(probe);
+            if (live) {
+                std::cerr << "Error: Metrics socket '" << path << "' is in use by another process\n";
+                close(listenFd_);
+                listenFd_ = -1;
+                return false;
+            }
+            unlink(path.c_str());
+        }
+        if (bind(listenFd_, (sockaddr*)&addr, sizeof(addr)) != 0 || lstat(path.c_str(), &st) != 0) {
+            std::cerr << "Error: Could not bind metrics socket '" << path << "'\n";
+            close(listenFd_);
+            listenFd_ = -1;
+            return false;
+        }
+        unixPath_ = path;
+        unixDev_ = (uint64_t)st.st_dev;
+        unixIno_ = (uint64_t)st.st_ino;
+        address_ = spec;
+    } else {
+        std::string host = "127.0.0.1";
+        std::string port = spec;
+        size_t colon = spec.rfind(':');
+        if (colon != std::string::npos) {
+            host = spec.substr(0, colon);
+            port = spec.substr(colon + 1);
+        }
+        if (host == "localhost") host = "127.0.0.1";
+        char* end = nullptr;
+        long portNum = std::strtol(port.c_str(), &end, 10);
+        if (port.empty() || *end != '\0' || portNum < 1 || portNum > 65535) {
+            std::cerr << "Error: Invalid metrics port '" << port << "'\n";
+            return false;
+        }
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)portNum);
+        if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1 ||
+            (ntohl(addr.sin_addr.s_addr) >> 24) != 127) {
+            std::cerr << "Error: Metrics listener must use a loopback address (got '" << host << "')\n";
+            return false;
+        }
+        listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (listenFd_ < 0) {
+            std::cerr << "Error: Could not create metrics socket\n";
+            return false;
+        }
+        int reuse = 1;
+        setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (bind(listenFd_, (sockaddr*)&addr, sizeof(addr)) != 0) {
+            std::cerr << "Error: Could not bind metrics listener to " << host << ":" << portNum << "\n";
+            close(listenFd_);
+            listenFd_ = -1;
+            return false;
+        }
+        address_ = host + ":" + std::to_string(portNum);
+    }
+
+    if (listen(listenFd_, 8) != 0) {
+        std::cerr << "Error: Could not listen on metrics socket\n";
+        stop();
+        return false;
+    }
+    stopping_.store(false);
+    thread_ = std::thread([this]() { serveLoop(); });
+    return true;
+}
+
+void MetricsServer::stop() {
+    stopping_.store(true);
+    if (thread_.joinable()) thread_.join();
+    if (listenFd_ >= 0) {
+        close(listenFd_);
+        listenFd_ = -1;
+    }
+    if (!unixPath_.empty()) {
+        struct stat st;
+        if (lstat(unixPath_.c_str(), &st) == 0 && S_ISSOCK(st.st_mode) &&
+            (uint64_t)st.st_dev == unixDev_ && (uint64_t)st.st_ino == unixIno_) {
+            unlink(unixPath_.c_str());
+        }
+        unixPath_.clear();
+    }
+}
+
+void MetricsServer::serveLoop() {
+    while (!stopping_.load()) {
+        // Poll with a timeout so stop() never waits on a blocked accept().
+        pollfd pfd{listenFd_, POLLIN, 0};
+        int ready = poll(&pfd, 1, 200);
+        if (ready <= 0 || !(pfd.revents & POLLIN)) continue;
+        int client = accept(listenFd_, nullptr, nullptr);
+        if (client < 0) continue;
+        timeval timeout{kClientTimeoutMs / 1000, (kClientTimeoutMs % 1000) * 1000};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#ifdef SO_NOSIGPIPE
+        int noSigpipe = 1;
+        setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &noSigpipe, sizeof(noSigpipe));
+#endif
+        handleClient(client);
+        close(client);
+    }
+}
+
+void MetricsServer::handleClient(int fd) {
+    // Read until the end of the request headers; scrapers send tiny requests.
+    // The deadline covers the whole request, not each read.
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kClientTimeoutMs);
+    std::string request;
+    char buf[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.find("\n\n") == std::string::npos &&
+           request.size() < 8192) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (left.count() <= 0) return;
+        pollfd pfd{fd, POLLIN, 0};
+        if (poll(&pfd, 1, (int)left.count()) <= 0) return;
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) break;
+        request.append(buf, (size_t)n);
+    }
+
+    std::string path;
+    std::istringstream line(request);
+    std::string method;
+    line >> method >> path;
+
+    std::string status = "200 OK";
+    std::string body;
+    if (method != "GET") {
+        status = "405 Method Not Allowed";
+        body = "GET only\n";
+    } else if (path == "/metrics" || path == "/") {
+        body = metrics_.renderPrometheus();
+    } else {
+        status = "404 Not Found";
+        body = "not found\n";
+    }
+
+    std::string response = "HTTP/1.0 " + status + "\r\n"
+                           "Content-Type: text/plain; version=0.0.4\r\n"
+                           "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                           "Connection: close\r\n\r\n" + body;
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t n = send(fd, response.data() + sent, response.size() - sent, kSendFlags);
+        if (n <= 0) break;
+        sent += (size_t)n;
+    }
+}
+
+#endif
+
+} // namespace metrics
@@ -0,0 +1,104 @@
+// metrics.h
+// Live pipeline metrics and a local Prometheus text-format listener.
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace metrics {
+
+// Resident set size of this process in bytes, or -1 if unknown on this
+// platform.
+long long residentBytes();
+
+struct StageGauges {
+    std::string name;
+    std::atomic<uint64_t> busyNanos{0};
+    std::atomic<uint64_t> frames{0};
+    // Frames waiting in this stage's output queue.
+    std::atomic<int> queueDepth{0};
+};
+
+// Counters updated by the pipeline threads and read by the metrics listener.
+// Per-frame updates are lock-free; the mutexes guard the stage list, which
+// changes once per run, and the fps window, which rolls once per second.
+class PipelineMetrics {
+public:
+    // `workers` is the pool size the stages share; busy ratios are relative
+    // to it.
+    void beginRun(const std::vector<std::string>& stageNames, int totalFrames, size_t queueCapacity, int workers);
+    void endRun();
+
+    // Valid between beginRun and the next beginRun.
+    StageGauges& stage(size_t index) { return *stages_[index]; }
+
+    // Called by the writer thread around handing each frame to the encoder.
+    void writeStarted();
+    void frameWritten(uint64_t writeNanos);
+
+    std::string renderPrometheus() const;
+
+private:
+    mutable std::mutex mu_;
+    std::vector<std::unique_ptr<StageGauges>> stages_;
+    int totalFrames_ = 0;
+    size_t queueCapacity_ = 0;
+    int workers_ = 1;
+    std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> framesWritten_{0};
+    std::atomic<uint64_t> writeNanos_{0};
+    // Start of the write in progress (ns after start_, plus one), 0 if idle.
+    std::atomic<uint64_t> writeStartNanos_{0};
+    // One-second fps window. The writer rolls it after a frame; scrapes read
+    // it so fps and ETA keep falling while the encoder stalls. Written only
+    // by the writer thread, under windowMu_.
+    mutable std::mutex windowMu_;
+    std::chrono::steady_clock::time_point windowStart_;
+    uint64_t windowFrames_ = 0;
+    double lastWindowFps_ = 0.0;
+};
+
+// Serves PipelineMetrics over HTTP on a loopback TCP port or a UNIX socket.
+class MetricsServer {
+public:
+    explicit MetricsServer(const PipelineMetrics& metrics) : metrics_(metrics) {}
+    ~MetricsServer() { stop(); }
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // `spec` is "<port>", "127.0.0.1:<port>", "localhost:<port>" or
+    // "unix:<path>". Only loopback addresses are accepted.
+    bool start(const std::string& spec);
+    void stop();
+
+    const std::string& address() const { return address_; }
+
+private:
+    void serveLoop();
+    void handleClient(int fd);
+
+    const PipelineMetrics& metrics_;
+    int listenFd_ = -1;
+    // Socket file this process bound, identified so stop() never removes a
+    // file that replaced it.
+    std::string unixPath_;
+    uint64_t unixDev_ = 0;
+    uint64_t unixIno_ = 0;
+    std::string address_;
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+};
+
+} // namespace metrics
+
+#endif // METRICS_H
@@ -0,0 +1,227 @@
+// perf_stats.cpp
+// Per-stage timing and hardware performance counters for --stats.
+
+#include "perf_stats.h"
+#include <cstring>
+#include <iomanip>
+
+#ifdef __linux__
+    #include <linux/perf_event.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+namespace perfstats {
+
+const char* phaseName(Phase phase) {
+    switch (phase) {
+        case PhaseRender: return "render";
+        case PhasePostProcess: return "postprocess";
+        case PhaseUpdate: return "update";
+        case PhaseWrite: return "write";
+        default: return "?";
+    }
+}
+
+ThreadCounters& ThreadCounters::forThisThread() {
+    thread_local ThreadCounters counters;
+    return counters;
+}
+
+ThreadCounters::ThreadCounters() {
+#ifdef __linux__
+    static const uint32_t types[CounterCount] = {
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE
+    };
+    static const uint64_t configs[CounterCount] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    bool ok = true;
+    for (int i = 0; i < CounterCount; ++i) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = types[i];
+        attr.config = configs[i];
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.inherit = 0;
+        // User space only so the default perf_event_paranoid level allows it.
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fds_[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (fds_[i] < 0) {
+            ok = false;
+            break;
+        }
+    }
+    if (!ok) {
+        for (int& fd : fds_) {
+            if (fd >= 0) close(fd);
+            fd = -1;
+        }
+        return;
+    }
+    available_ = true;
+#endif
+}
+
+ThreadCounters::~ThreadCounters() {
+#ifdef __linux__
+    for (int& fd : fds_) {
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+#endif
+}
+
+bool ThreadCounters::read(double* out) {
+#ifdef __linux__
+    if (!available_) return false;
+    for (int i = 0; i < CounterCount; ++i) {
+        uint64_t buf[3] = {0, 0, 0};
+        if (::read(fds_[i], buf, sizeof(buf)) != (ssize_t)sizeof(buf)) {
+            available_ = false;
+            return false;
+        }
+        // Scale for multiplexing when the PMU couldn't count all events at once.
+        double value = (double)buf[0];
+        if (buf[2] > 0 && buf[2] < buf[1]) value *= (double)buf[1] / (double)buf[2];
+        out[i] = value;
+    }
+    return true;
+#else
+    (void)out;
+    return false;
+#endif
+}
+
+void StageRecorder::add(Phase phase, uint64_t calls, double seconds, const double* counters) {
+    std::lock_guard<std::mutex> lock(mu_);
+    PhaseTotals& t = totals_[phase];
+    t.calls += calls;
+    t.seconds += seconds;
+    if (counters) {
+        hasCounters_ = true;
+        for (int i = 0; i < CounterCount; ++i) {
+            t.counters[i] += counters[i];
+        }
+    }
+}
+
+bool StageRecorder::hasCounters() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return hasCounters_;
+}
+
+PhaseTotals StageRecorder::totals(Phase phase) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return totals_[phase];
+}
+
+namespace {
+thread_local PhaseScope* tCurrentScope = nullptr;
+}
+
+PhaseScope* PhaseScope::current() {
+    return tCurrentScope;
+}
+
+PhaseScope::PhaseScope(StageRecorder* recorder, Phase phase) : recorder_(recorder), phase_(phase) {
+    if (!recorder_) return;
+    previous_ = tCurrentScope;
+    tCurrentScope = this;
+    ThreadCounters& counters = ThreadCounters::forThisThread();
+    if (counters.read(startCounters_)) counters_ = &counters;
+    start_ = std::chrono::steady_clock::now();
+}
+
+PhaseScope::~PhaseScope() {
+    if (!recorder_) return;
+    tCurrentScope = previous_;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    double values[CounterCount];
+    if (counters_ && counters_->read(values)) {
+        std::lock_guard<std::mutex> lock(helperMu_);
+        for (int i = 0; i < CounterCount; ++i) {
+            values[i] = values[i] - startCounters_[i] + helperCounters_[i];
+        }
+        recorder_->add(phase_, 1, seconds, values);
+    } else {
+        recorder_->add(phase_, 1, seconds);
+    }
+}
+
+void PhaseScope::addHelperCounters(const double* counters) {
+    std::lock_guard<std::mutex> lock(helperMu_);
+    for (int i = 0; i < CounterCount; ++i) {
+        helperCounters_[i] += counters[i];
+    }
+}
+
+HelperScope::HelperScope(PhaseScope* parent) : parent_(parent) {
+    if (!parent_) return;
+    ThreadCounters& counters = ThreadCounters::forThisThread();
+    if (counters.read(startCounters_)) counters_ = &counters;
+}
+
+HelperScope::~HelperScope() {
+    if (!counters_) return;
+    double values[CounterCount];
+    if (!counters_->read(values)) return;
+    for (int i = 0; i < CounterCount; ++i) {
+        values[i] -= startCounters_[i];
+    }
+    parent_->addHelperCounters(values);
+}
+
+void printReport(std::ostream& os, const std::vector<const StageRecorder*>& stages) {
+    bool anyCounters = false;
+    for (const StageRecorder* s : stages) {
+        if (s && s->hasCounters()) anyCounters = true;
+    }
+
+    std::ios oldState(nullptr);
+    oldState.copyfmt(os);
+
+    os << "\nStage statistics:\n";
+    os << std::left << std::setw(24) << "  stage" << std::setw(12) << "phase"
+       << std::right << std::setw(8) << "calls" << std::setw(10) << "total s" << std::setw(10) << "ms/call";
+    if (anyCounters) {
+        os << std::setw(10) << "Mcycles" << std::setw(8) << "IPC"
+           << std::setw(12) << "LLC/kinst" << std::setw(12) << "brmiss/kinst";
+    }
+    os << "\n";
+
+    for (const StageRecorder* s : stages) {
+        if (!s) continue;
+        for (int p = 0; p < PhaseCount; ++p) {
+            const PhaseTotals t = s->totals((Phase)p);
+            if (t.calls == 0) continue;
+            os << std::left << std::setw(24) << ("  " + s->name()) << std::setw(12) << phaseName((Phase)p)
+               << std::right << std::setw(8) << t.calls
+               << std::fixed << std::setprecision(3) << std::setw(10) << t.seconds
+               << std::setw(10) << (t.seconds * 1000.0 / (double)t.calls);
+            if (s->hasCounters()) {
+                double cycles = t.counters[CounterCycles];
+                double instructions = t.counters[CounterInstructions];
+                double llc = t.counters[CounterLLCMisses];
+                double branchMisses = t.counters[CounterBranchMisses];
+                os << std::setprecision(1) << std::setw(10) << cycles / 1e6
+                   << std::setprecision(2) << std::setw(8) << (cycles > 0.0 ? instructions / cycles : 0.0)
+                   << std::setw(12) << (instructions > 0.0 ? llc * 1000.0 / instructions : 0.0)
+                   << std::setw(12) << (instructions > 0.0 ? branchMisses * 1000.0 / instructions : 0.0);
+            }
+            os << "\n";
+        }
+    }
+    if (!anyCounters) {
+        os << "  (hardware counters unavailable; showing wall-clock timings only)\n";
+    }
+    os.copyfmt(oldState);
+}
+
+} // namespace perfstats
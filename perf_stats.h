@@ -0,0 +1,134 @@
+// perf_stats.h
+// Per-stage timing and hardware performance counters for --stats.
+
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace perfstats {
+
+enum Counter {
+    CounterCycles,
+    CounterInstructions,
+    CounterLLCMisses,
+    CounterBranchMisses,
+    CounterCount
+};
+
+enum Phase {
+    PhaseRender,
+    PhasePostProcess,
+    PhaseUpdate,
+    PhaseWrite,
+    PhaseCount
+};
+
+const char* phaseName(Phase phase);
+
+struct PhaseTotals {
+    uint64_t calls = 0;
+    double seconds = 0.0;
+    double counters[CounterCount] = {};
+};
+
+// Hardware counters for the calling thread only, opened on first use and kept
+// for the thread's lifetime. Child threads are not inherited; long-lived
+// helper threads report into the phase they work for through HelperScope.
+class ThreadCounters {
+public:
+    static ThreadCounters& forThisThread();
+    ~ThreadCounters();
+
+    ThreadCounters(const ThreadCounters&) = delete;
+    ThreadCounters& operator=(const ThreadCounters&) = delete;
+
+    // False if perf_event_open is unavailable or denied on this thread.
+    bool available() const { return available_; }
+    bool read(double* out);
+
+private:
+    ThreadCounters();
+
+    int fds_[CounterCount] = {-1, -1, -1, -1};
+    bool available_ = false;
+};
+
+// Accumulates wall time and (on Linux, when permitted) hardware counters for
+// the phases of one pipeline stage. Phases may be measured on any thread,
+// including several at once.
+class StageRecorder {
+public:
+    explicit StageRecorder(std::string name) : name_(std::move(name)) {}
+
+    StageRecorder(const StageRecorder&) = delete;
+    StageRecorder& operator=(const StageRecorder&) = delete;
+
+    // `counters` holds per-counter deltas, or nullptr for wall time only.
+    void add(Phase phase, uint64_t calls, double seconds, const double* counters = nullptr);
+
+    const std::string& name() const { return name_; }
+    bool hasCounters() const;
+    PhaseTotals totals(Phase phase) const;
+
+private:
+    std::string name_;
+    mutable std::mutex mu_;
+    bool hasCounters_ = false;
+    PhaseTotals totals_[PhaseCount];
+};
+
+// Measures one phase on the calling thread from construction to destruction,
+// plus whatever helper threads add to it. A null recorder makes it a no-op.
+class PhaseScope {
+public:
+    PhaseScope(StageRecorder* recorder, Phase phase);
+    ~PhaseScope();
+
+    PhaseScope(const PhaseScope&) = delete;
+    PhaseScope& operator=(const PhaseScope&) = delete;
+
+    // Innermost active scope on the calling thread, or nullptr.
+    static PhaseScope* current();
+
+    // Counter deltas measured on a helper thread working for this phase.
+    void addHelperCounters(const double* counters);
+
+private:
+    StageRecorder* recorder_;
+    Phase phase_;
+    PhaseScope* previous_ = nullptr;
+    ThreadCounters* counters_ = nullptr;
+    std::chrono::steady_clock::time_point start_;
+    double startCounters_[CounterCount] = {};
+    std::mutex helperMu_;
+    double helperCounters_[CounterCount] = {};
+};
+
+// Counts the calling helper thread's work toward `parent` (no-op if null).
+// `parent` is PhaseScope::current() on the dispatching thread; the helper's
+// work must finish before that phase ends.
+class HelperScope {
+public:
+    explicit HelperScope(PhaseScope* parent);
+    ~HelperScope();
+
+    HelperScope(const HelperScope&) = delete;
+    HelperScope& operator=(const HelperScope&) = delete;
+
+private:
+    PhaseScope* parent_;
+    ThreadCounters* counters_ = nullptr;
+    double startCounters_[CounterCount] = {};
+};
+
+void printReport(std::ostream& os, const std::vector<const StageRecorder*>& stages);
+
+} // namespace perfstats
+
+#endif // PERF_STATS_H
@@ -13,6 +13,12 @@ SOURCES=(
   main.cpp
   effect_generator.cpp
   json_util.cpp
+  autotune.cpp
+  perf_stats.cpp
+  metrics.cpp
+  segment_job.cpp
+  estimate.cpp
+  task_pool.cpp
   snowflake_effect.cpp
   laser_effect.cpp
   loopfade_effect.cpp
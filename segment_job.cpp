@@ -0,0 +1,542 @@
+// segment_job.cpp
+// Splitting a render into time segments that worker processes on any host
+// can claim from a shared job directory.
+
+#include "segment_job.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+    #include <process.h>
+#else
+    #include <signal.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace segmentjob {
+
+namespace {
+
+const char* kItemHeader = "effectgenerator-segment 1";
+const char* kSeedHeader = "effectgenerator-job 1";
+const char* kLockHeader = "effectgenerator-lock 2";
+
+// How often a rendering worker touches its lock file.
+const int kHeartbeatSeconds = 15;
+
+std::string indexName(int index) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "seg-%04d", index);
+    return buf;
+}
+
+std::string seedPath(const std::string& dir) {
+    return (fs::path(dir) / "job.seed").string();
+}
+
+std::string lockPath(const std::string& dir, int index) {
+    return (fs::path(dir) / (indexName(index) + ".lock")).string();
+}
+
+std::string failedPath(const std::string& dir, int index) {
+    return (fs::path(dir) / (indexName(index) + ".failed")).string();
+}
+
+// Where a segment is written while rendering; renamed to `output` when done.
+std::string partialPath(const std::string& output) {
+    fs::path p(output);
+    return (p.parent_path() / (p.stem().string() + ".part" + p.extension().string())).string();
+}
+
+std::string serializeItem(const WorkItem& item) {
+    std::ostringstream os;
+    os << kItemHeader << "\n";
+    os << "index=" << item.index << "\n";
+    os << "output=" << item.output << "\n";
+    for (const auto& a : item.args) os << "arg=" << a << "\n";
+    return os.str();
+}
+
+bool parseItem(const std::string& path, WorkItem& item) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    if (!std::getline(in, line) || line != kItemHeader) return false;
+    item = WorkItem{};
+    bool haveIndex = false;
+    while (std::getline(in, line)) {
+        if (line.rfind("index=", 0) == 0) {
+            item.index = std::atoi(line.c_str() + 6);
+            haveIndex = true;
+        } else if (line.rfind("output=", 0) == 0) {
+            item.output = line.substr(7);
+        } else if (line.rfind("arg=", 0) == 0) {
+            item.args.push_back(line.substr(4));
+        }
+    }
+    return haveIndex && !item.output.empty();
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path);
+    std::ostringstream os;
+    os << in.rdbuf();
+    return os.str();
+}
+
+bool writeFileAtomically(const std::string& path, const std::string& contents) {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        if (!out) return false;
+        out << contents;
+        if (!out) return false;
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    return !ec;
+}
+
+std::string hostName() {
+    std::string host;
+#ifdef _WIN32
+    const char* name = std::getenv("COMPUTERNAME");
+    if (name) host = name;
+#else
+    char name[256] = {0};
+    if (gethostname(name, sizeof(name) - 1) == 0) host = name;
+#endif
+    if (host.empty()) host = "unknown";
+    return host;
+}
+
+int processId() {
+#ifdef _WIN32
+    return _getpid();
+#else
+    return (int)getpid();
+#endif
+}
+
+std::string workerIdentity() {
+    return hostName() + " pid " + std::to_string(processId());
+}
+
+bool fileExists(const std::string& path) {
+    std::error_code ec;
+    return fs::exists(path, ec);
+}
+
+struct LockInfo {
+    std::string host;
+    int pid = 0;
+};
+
+std::string lockContents() {
+    std::ostringstream os;
+    os << kLockHeader << "\n";
+    os << "host=" << hostName() << "\n";
+    os << "pid=" << processId() << "\n";
+    return os.str();
+}
+
+bool parseLock(const std::string& contents, LockInfo& info) {
+    std::istringstream in(contents);
+    std::string line;
+    if (!std::getline(in, line) || line != kLockHeader) return false;
+    info = LockInfo{};
+    while (std::getline(in, line)) {
+        if (line.rfind("host=", 0) == 0) info.host = line.substr(5);
+        else if (line.rfind("pid=", 0) == 0) info.pid = std::atoi(line.c_str() + 4);
+    }
+    return !info.host.empty() && info.pid > 0;
+}
+
+bool ownedByThisProcess(const LockInfo& info) {
+    return info.host == hostName() && info.pid == processId();
+}
+
+// Owners on other hosts are assumed alive; only their heartbeat can age out.
+bool ownerAlive(const LockInfo& info) {
+    if (info.host != hostName()) return true;
+#ifdef _WIN32
+    return true;
+#else
+    return kill((pid_t)info.pid, 0) == 0 || errno == EPERM;
+#endif
+}
+
+// Set a file's modification time to "now" as the filesystem sees it. With a
+// null time, NFS clients ask the server to use its own clock, so heartbeats
+// from hosts with skewed clocks still compare correctly.
+void touchFile(std::FILE* file, const std::string& path) {
+#ifdef _WIN32
+    (void)file;
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+#else
+    (void)path;
+    futimens(fileno(file), nullptr);
+#endif
+}
+
+// Current time on the filesystem holding `dir`: the modification time of a
+// file created there just now. Lock ages are measured against this rather
+// than against this host's clock.
+bool sharedNow(const std::string& dir, fs::file_time_type& now) {
+    std::string probe = (fs::path(dir) / (".clock-" + hostName() + "-" + std::to_string(processId()))).string();
+    std::FILE* file = std::fopen(probe.c_str(), "w");
+    if (!file) return false;
+    touchFile(file, probe);
+    std::fclose(file);
+    std::error_code ec;
+    now = fs::last_write_time(probe, ec);
+    fs::remove(probe, ec);
+    return true;
+}
+
+// Identity and heartbeat of a lock file, to tell whether the file found
+// after a rename is the one that was judged stale.
+struct LockStamp {
+    uint64_t device = 0;
+    uint64_t inode = 0;
+    fs::file_time_type heartbeat;
+};
+
+bool stampLock(const std::string& path, LockStamp& stamp) {
+#ifndef _WIN32
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) return false;
+    stamp.device = (uint64_t)st.st_dev;
+    stamp.inode = (uint64_t)st.st_ino;
+#endif
+    std::error_code ec;
+    stamp.heartbeat = fs::last_write_time(path, ec);
+    return !ec;
+}
+
+bool sameLock(const LockStamp& a, const LockStamp& b) {
+    return a.device == b.device && a.inode == b.inode && a.heartbeat == b.heartbeat;
+}
+
+bool lockIsStale(const std::string& contents, const LockStamp& stamp, fs::file_time_type now) {
+    LockInfo info;
+    if (parseLock(contents, info)) {
+        if (ownedByThisProcess(info)) return false;
+        if (!ownerAlive(info)) return true;
+    }
+    // Live owners elsewhere, and locks still being written, go by the age
+    // of the last heartbeat.
+    return now - stamp.heartbeat > std::chrono::seconds(kStaleLockSeconds);
+}
+
+// Put a lock that was moved aside by mistake back, unless a new claim has
+// taken its place meanwhile.
+void restoreLock(const std::string& aside, const std::string& path) {
+#ifdef _WIN32
+    std::error_code ec;
+    if (!fileExists(path)) fs::rename(aside, path, ec);
+#else
+    if (::link(aside.c_str(), path.c_str()) == 0) {
+        ::unlink(aside.c_str());
+        return;
+    }
+    std::cerr << "Warning: Could not restore live lock " << path << "; left it at " << aside << "\n";
+#endif
+}
+
+// Move a stale lock aside so the segment can be claimed again. The lock is
+// renamed first and then compared with what was judged stale: a different
+// file, or one whose heartbeat moved since, is a live claim and is put back.
+bool reclaimStaleLock(const std::string& dir, int index) {
+    std::string path = lockPath(dir, index);
+    LockStamp before;
+    fs::file_time_type now;
+    if (!stampLock(path, before) || !sharedNow(dir, now)) return false;
+    std::string contents = readFile(path);
+    if (!lockIsStale(contents, before, now)) return false;
+    std::string aside = path + ".stale-" + hostName() + "-" + std::to_string(processId());
+    std::error_code ec;
+    fs::rename(path, aside, ec);
+    if (ec) return false;
+    LockStamp after;
+    if (!stampLock(aside, after) || !sameLock(before, after) || readFile(aside) != contents) {
+        restoreLock(aside, path);
+        return false;
+    }
+    LockInfo info;
+    std::string owner = parseLock(contents, info) ? info.host + " pid " + std::to_string(info.pid) : "unknown owner";
+    std::cerr << "Worker: reclaiming segment " << index << " from " << owner << " (worker gone or heartbeat stale)\n";
+    fs::remove(aside, ec);
+    return true;
+}
+
+// Claim a segment by creating its lock file exclusively. Exclusive create
+// is atomic on local filesystems and on NFSv3+ shares. The file stays open
+// so the heartbeat touches this very file, never a lock that replaced it.
+std::FILE* createLock(const std::string& dir, int index) {
+    std::FILE* lock = std::fopen(lockPath(dir, index).c_str(), "wx");
+    if (!lock) return nullptr;
+    std::fputs(lockContents().c_str(), lock);
+    std::fflush(lock);
+    return lock;
+}
+
+std::FILE* tryClaim(const std::string& dir, int index) {
+    if (std::FILE* lock = createLock(dir, index)) return lock;
+    return reclaimStaleLock(dir, index) ? createLock(dir, index) : nullptr;
+}
+
+// Remove our lock file, but only if the path still names it.
+void releaseLock(std::FILE* lock, const std::string& path) {
+#ifdef _WIN32
+    std::fclose(lock);
+    std::remove(path.c_str());
+#else
+    struct stat mine;
+    struct stat current;
+    if (fstat(fileno(lock), &mine) == 0 && ::stat(path.c_str(), &current) == 0 &&
+        mine.st_dev == current.st_dev && mine.st_ino == current.st_ino) {
+        ::unlink(path.c_str());
+    }
+    std::fclose(lock);
+#endif
+}
+
+// Refreshes the heartbeat (modification time) of a claimed lock until
+// destroyed. The lock's contents are never rewritten.
+class LockHeartbeat {
+public:
+    LockHeartbeat(std::FILE* lock, std::string path) : lock_(lock), path_(std::move(path)) {
+        thread_ = std::thread([this]() {
+            std::unique_lock<std::mutex> guard(mu_);
+            while (!cv_.wait_for(guard, std::chrono::seconds(kHeartbeatSeconds), [this]() { return stop_; })) {
+                touchFile(lock_, path_);
+            }
+        });
+    }
+
+    ~LockHeartbeat() {
+        {
+            std::lock_guard<std::mutex> guard(mu_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        thread_.join();
+    }
+
+    LockHeartbeat(const LockHeartbeat&) = delete;
+    LockHeartbeat& operator=(const LockHeartbeat&) = delete;
+
+private:
+    std::FILE* lock_;
+    std::string path_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+} // namespace
+
+std::string itemPath(const std::string& dir, int index) {
+    return (fs::path(dir) / (indexName(index) + ".job")).string();
+}
+
+std::string segmentPath(const std::string& dir, int index, const std::string& extension) {
+    return (fs::absolute(fs::path(dir)) / (indexName(index) + extension)).string();
+}
+
+bool readJobSeed(const std::string& dir, uint32_t& seed) {
+    std::ifstream in(seedPath(dir));
+    std::string line;
+    if (!in || !std::getline(in, line) || line != kSeedHeader) return false;
+    while (std::getline(in, line)) {
+        if (line.rfind("seed=", 0) == 0) {
+            seed = (uint32_t)std::strtoul(line.c_str() + 5, nullptr, 10);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool publish(const std::string& dir, const std::vector<WorkItem>& items, uint32_t seed) {
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if (ec) {
+        std::cerr << "Error: Could not create job directory '" << dir << "': " << ec.message() << "\n";
+        return false;
+    }
+    uint32_t existingSeed = 0;
+    if (readJobSeed(dir, existingSeed)) {
+        if (existingSeed != seed) {
+            std::cerr << "Error: Job directory '" << dir << "' holds a job with seed " << existingSeed
+                      << " (got --seed " << seed << "). Use an empty directory.\n";
+            return false;
+        }
+    } else {
+        std::string contents = std::string(kSeedHeader) + "\nseed=" + std::to_string(seed) + "\n";
+        if (!writeFileAtomically(seedPath(dir), contents)) {
+            std::cerr << "Error: Could not write " << seedPath(dir) << "\n";
+            return false;
+        }
+    }
+    int reused = 0;
+    for (const auto& item : items) {
+        for (const auto& a : item.args) {
+            if (a.find('\n') != std::string::npos) {
+                std::cerr << "Error: Arguments containing newlines cannot be published as segments\n";
+                return false;
+            }
+        }
+        std::string path = itemPath(dir, item.index);
+        std::string contents = serializeItem(item);
+        if (fileExists(path)) {
+            if (readFile(path) != contents) {
+                std::cerr << "Error: Job directory '" << dir << "' already holds a different job ("
+                          << path << "). Use an empty directory.\n";
+                return false;
+            }
+            ++reused;
+            continue;
+        }
+        if (!writeFileAtomically(path, contents)) {
+            std::cerr << "Error: Could not write work item " << path << "\n";
+            return false;
+        }
+    }
+    if (reused > 0) {
+        std::cerr << "Resuming job in " << dir << " (" << reused << " of " << items.size()
+                  << " work items already published)\n";
+    }
+    return true;
+}
+
+int runWorker(const std::string& dir, const RenderFn& render) {
+    std::error_code ec;
+    if (!fs::is_directory(dir, ec)) {
+        std::cerr << "Error: Job directory '" << dir << "' does not exist\n";
+        return -1;
+    }
+
+    std::vector<std::string> itemFiles;
+    for (const auto& entry : fs::directory_iterator(dir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("seg-", 0) == 0 && entry.path().extension() == ".job") {
+            itemFiles.push_back(entry.path().string());
+        }
+    }
+    if (ec) {
+        std::cerr << "Error: Could not list job directory '" << dir << "': " << ec.message() << "\n";
+        return -1;
+    }
+    std::sort(itemFiles.begin(), itemFiles.end());
+
+    int rendered = 0;
+    for (const auto& file : itemFiles) {
+        WorkItem item;
+        if (!parseItem(file, item)) {
+            std::cerr << "Warning: Skipping unreadable work item " << file << "\n";
+            continue;
+        }
+        if (fileExists(item.output) || fileExists(failedPath(dir, item.index))) continue;
+        std::string lock = lockPath(dir, item.index);
+        std::FILE* claim = tryClaim(dir, item.index);
+        if (!claim) continue;
+        // Another worker may have finished between our check and the claim.
+        if (fileExists(item.output)) {
+            releaseLock(claim, lock);
+            continue;
+        }
+
+        std::cerr << "Worker: rendering segment " << item.index << " -> " << item.output << "\n";
+        std::string partial = partialPath(item.output);
+        std::vector<std::string> args = {"--output", partial, "--overwrite"};
+        args.insert(args.end(), item.args.begin(), item.args.end());
+        int rc = 0;
+        {
+            LockHeartbeat heartbeat(claim, lock);
+            rc = render(args);
+        }
+
+        std::error_code sizeEc;
+        bool wrote = fileExists(partial) && fs::file_size(partial, sizeEc) > 0 && !sizeEc;
+        std::error_code renameEc;
+        if (rc == 0 && wrote) {
+            fs::rename(partial, item.output, renameEc);
+        }
+        if (rc != 0 || !wrote || renameEc) {
+            std::ostringstream why;
+            why << workerIdentity() << ": ";
+            if (rc != 0) why << "render exited with status " << rc;
+            else if (!wrote) why << "no output was written";
+            else why << "could not rename output: " << renameEc.message();
+            writeFileAtomically(failedPath(dir, item.index), why.str() + "\n");
+            std::remove(partial.c_str());
+            std::cerr << "Worker: segment " << item.index << " failed (" << why.str() << ")\n";
+        } else {
+            ++rendered;
+        }
+        releaseLock(claim, lock);
+    }
+    return rendered;
+}
+
+bool waitForSegments(const std::string& dir, const std::vector<WorkItem>& items, const RenderFn& render) {
+    bool announced = false;
+    while (true) {
+        size_t done = 0;
+        bool claimable = false;
+        fs::file_time_type now;
+        bool haveNow = sharedNow(dir, now);
+        for (const auto& item : items) {
+            std::string failed = failedPath(dir, item.index);
+            if (fileExists(failed)) {
+                std::cerr << "Error: Segment " << item.index << " failed: " << readFile(failed)
+                          << "Remove " << failed << " and publish again to retry.\n";
+                return false;
+            }
+            if (fileExists(item.output)) {
+                ++done;
+                continue;
+            }
+            std::string lock = lockPath(dir, item.index);
+            LockStamp stamp;
+            if (!stampLock(lock, stamp)) {
+                claimable = true;
+            } else if (haveNow && lockIsStale(readFile(lock), stamp, now)) {
+                claimable = true;
+            }
+        }
+        if (done == items.size()) return true;
+        if (claimable) {
+            // A worker died (or its lock went stale); pick its segment up here.
+            int rendered = runWorker(dir, render);
+            if (rendered < 0) return false;
+            // Rescan at once only if that made progress; a claim lost to
+            // another worker backs off like any other wait.
+            if (rendered > 0) continue;
+        }
+        if (!announced) {
+            std::cerr << "Waiting for " << (items.size() - done) << " segment(s) being rendered by other workers "
+                      << "(segments whose worker dies are reclaimed after at most " << kStaleLockSeconds << "s)...\n";
+            announced = true;
+        }
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+}
+
+} // namespace segmentjob
@@ -0,0 +1,61 @@
+// segment_job.h
+// Splitting a render into time segments that worker processes on any host
+// can claim from a shared job directory.
+//
+// Layout of a job directory:
+//   job.seed         seed the segment seeds were derived from
+//   seg-NNNN.job     work item: output path and the full argument list
+//   seg-NNNN.lock    claim marker, created exclusively by the rendering worker;
+//                    holds its host and pid. The worker touches it while
+//                    rendering, so its modification time is the heartbeat
+//   seg-NNNN.failed  error note left by a worker whose render failed
+//   seg-NNNN<ext>    finished segment (renamed into place when complete)
+
+#ifndef SEGMENT_JOB_H
+#define SEGMENT_JOB_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace segmentjob {
+
+struct WorkItem {
+    int index = 0;
+    std::string output;             // finished segment path
+    std::vector<std::string> args;  // effectgenerator arguments, without --output
+};
+
+// Renders one segment; `args` excludes argv[0]. Returns a process exit code.
+using RenderFn = std::function<int(const std::vector<std::string>& args)>;
+
+std::string itemPath(const std::string& dir, int index);
+std::string segmentPath(const std::string& dir, int index, const std::string& extension);
+
+// A lock whose heartbeat is older than this is treated as abandoned. Ages are
+// measured on the shared filesystem's clock, not the hosts'.
+constexpr int kStaleLockSeconds = 120;
+
+// Seed recorded by an earlier publish into `dir`. Returns false if there is
+// none, e.g. for a new job directory.
+bool readJobSeed(const std::string& dir, uint32_t& seed);
+
+// Write work items and the job seed into `dir`, creating it if needed. Items
+// that already exist with identical contents are kept, so an interrupted job
+// can be resumed by publishing it again.
+bool publish(const std::string& dir, const std::vector<WorkItem>& items, uint32_t seed);
+
+// Claim and render unfinished items until none are left to claim. Locks left
+// by a worker that died on this host, or whose heartbeat is older than
+// kStaleLockSeconds, are reclaimed. Returns the number of segments rendered,
+// or -1 if the job directory is unusable.
+int runWorker(const std::string& dir, const RenderFn& render);
+
+// Block until every item has a finished segment, rendering any segment whose
+// worker died in the meantime. Returns false if any segment failed.
+bool waitForSegments(const std::string& dir, const std::vector<WorkItem>& items, const RenderFn& render);
+
+} // namespace segmentjob
+
+#endif // SEGMENT_JOB_H
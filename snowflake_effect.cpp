@@ -32,6 +32,20 @@ struct Snowflake {
     float colorR;
     float colorG;
     float colorB;
+    // depth layer (0 = nearest, drawn at full resolution with per-flake softness)
+    int layer;
+};
+
+// Reduced-resolution accumulation buffer for one far depth layer. Flakes are
+// splatted crisp into it, then the whole layer is blurred once and composited.
+struct SnowDepthLayer {
+    int scale = 1;      // downscale factor relative to the output frame
+    int width = 0;
+    int height = 0;
+    int blurRadius = 0; // box blur radius in layer pixels
+    bool dirty = false;
+    std::vector<float> rgb;
+    std::vector<float> scratch;
 };
 
 class SnowflakeEffect : public Effect {
@@ -55,6 +69,11 @@ private:
     float avgMotionX_, avgMotionY_;
     float motionRandomness_;
     float softness_;
+    // Per-flake (near layer) brightness profile: the core dims by up to
+    // kCoreEdgeDim towards its rim, and the softness halo starts at
+    // kHaloAlpha and falls off with a smoothstep.
+    static constexpr float kCoreEdgeDim = 0.12f;
+    static constexpr float kHaloAlpha = 0.9f;
     float maxBrightness_;
     float brightnessSpeed_;
     // how long (seconds) a flake fades out after timeout
@@ -70,8 +89,11 @@ private:
     int spinAxis_; // 0=random, 1=horizontal, 2=vertical, 3=off
     ShapeMode shapeMode_;
     ColorMode colorMode_;
+    // depth-layered rendering: 0/1 = off (per-flake softness only)
+    int depthLayers_;
     
     std::vector<Snowflake> flakes_;
+    std::vector<SnowDepthLayer> layers_;
     std::mt19937 rng_;
     
     void hsvToRgb(float h, float s, float v, float &r, float &g, float &b) {
@@ -269,6 +291,7 @@ private:
         }
 
         assignFlakeColor(f);
+        f.layer = depthLayerForRadius(f.radius);
         // lifetime tracking: reset time and compute timeout based on estimated time to cross screen
         f.timeAlive = 0.0f;
         // estimate time to cross frame vertically (avoid divide by zero)
@@ -302,11 +325,11 @@ private:
                 if (ellDist < 1.0f + (softness_ / std::max(rx, ry))) {
                     if (ellDist <= 1.0f) {
                         float t = ellDist;
-                        alpha = 1.0f - t * 0.12f;
+                        alpha = 1.0f - t * kCoreEdgeDim;
                     } else {
                         float t = (ellDist - 1.0f) * (std::max(rx, ry) / softness_);
                         t = t * t * (3.0f - 2.0f * t);
-                        alpha = 0.9f * (1.0f - t);
+                        alpha = kHaloAlpha * (1.0f - t);
                     }
                 }
 
@@ -389,12 +412,183 @@ private:
             }
         }
     }
+    // Smaller flakes read as farther away. Flakes at or above the average size
+    // stay in the near layer; smaller ones are spread over the far layers.
+    int depthLayerForRadius(float radius) const {
+        if (depthLayers_ < 2) return 0;
+        if (radius >= avgSize_) return 0;
+        float span = std::max(0.0001f, avgSize_ - minSize_);
+        float depth = 1.0f - std::clamp((radius - minSize_) / span, 0.0f, 1.0f);
+        int far = depthLayers_ - 1;
+        return 1 + std::min(far - 1, (int)(depth * far));
+    }
+
+    void setupDepthLayers() {
+        layers_.clear();
+        if (depthLayers_ < 2) return;
+        // Downscaling only pays off when the blur hides the lost resolution,
+        // so the factor is capped by the halo width (2x at the default
+        // softness of 2).
+        int maxScale = std::max(1, (int)softness_);
+        layers_.resize(depthLayers_);
+        for (int k = 1; k < depthLayers_; ++k) {
+            SnowDepthLayer& L = layers_[k];
+            L.scale = std::min(1 << k, maxScale);
+            L.width = (width_ + L.scale - 1) / L.scale;
+            L.height = (height_ + L.scale - 1) / L.scale;
+            // Two box passes of radius softness/2 approximate the per-flake halo.
+            L.blurRadius = (int)std::round(softness_ * 0.5f / L.scale);
+            L.rgb.assign((size_t)L.width * L.height * 3, 0.0f);
+            L.scratch.assign(L.rgb.size(), 0.0f);
+            L.dirty = false;
+        }
+    }
+
+    // Draw a flake crisp (one layer pixel of antialiasing) into a depth layer.
+    // Small flakes are drawn at least half a layer pixel wide; each splat is
+    // normalized by its summed coverage so it deposits the flake's true area
+    // whatever the layer scale. That area is also scaled to the energy of the
+    // per-flake profile it replaces, so the blurred layer keeps the overall
+    // brightness of the unlayered render. Integrated over radius (in units of
+    // pi), the core gives r^2 (1 - 2/3 kCoreEdgeDim) and the smoothstep halo
+    // of width s gives kHaloAlpha (r s + 0.3 s^2).
+    void splatToLayer(SnowDepthLayer& L, float cx, float cy, float rx, float ry, float alpha, float colR, float colG, float colB) {
+        float r = std::sqrt(std::max(0.0001f, rx * ry));
+        const float coreEnergy = 1.0f - kCoreEdgeDim * 2.0f / 3.0f;
+        alpha *= (coreEnergy * r * r + kHaloAlpha * (r * softness_ + 0.3f * softness_ * softness_)) / (r * r);
+        if (alpha <= 0.0005f) return;
+        const float inv = 1.0f / (float)L.scale;
+        float lcx = cx * inv;
+        float lcy = cy * inv;
+        float lrx = rx * inv;
+        float lry = ry * inv;
+        float drawRx = std::max(0.5f, lrx);
+        float drawRy = std::max(0.5f, lry);
+
+        int minX = std::max(0, (int)(lcx - drawRx - 2));
+        int maxX = std::min(L.width - 1, (int)(lcx + drawRx + 2));
+        int minY = std::max(0, (int)(lcy - drawRy - 2));
+        int maxY = std::min(L.height - 1, (int)(lcy + drawRy + 2));
+        if (minX > maxX || minY > maxY) return;
+
+        const bool heart = (shapeMode_ == ShapeMode::Heart);
+        const float heartExtentX = 1.14f;
+        const float heartExtentY = 1.24f;
+        // Area of the unit heart curve (x^2 + y^2 - 1)^3 = x^2 y^3.
+        const float unitHeartArea = 3.662f;
+        const float normRx = heart ? drawRx / heartExtentX : drawRx;
+        const float normRy = heart ? drawRy / heartExtentY : drawRy;
+        const float edge = 1.0f / std::max(drawRx, drawRy);
+        const float area = heart ? unitHeartArea * (lrx / heartExtentX) * (lry / heartExtentY)
+                                 : 3.14159265f * lrx * lry;
+
+        auto coverageAt = [&](int x, int y) {
+            float dx = (x + 0.5f) - lcx;
+            float dy = (y + 0.5f) - lcy;
+            float nx = dx / normRx;
+            if (heart) {
+                float ny = -dy / normRy;
+                float a = nx * nx + ny * ny - 1.0f;
+                float F = (a * a * a) - (nx * nx * ny * ny * ny);
+                float dFdx = 6.0f * nx * a * a - 2.0f * nx * ny * ny * ny;
+                float dFdy = 6.0f * ny * a * a - 3.0f * nx * nx * ny * ny;
+                float grad = std::sqrt(dFdx * dFdx + dFdy * dFdy) + 0.0001f;
+                return 1.0f - smoothstep(-edge, edge, F / grad);
+            }
+            float ny = dy / normRy;
+            float ellDist = std::sqrt(nx * nx + ny * ny);
+            return 1.0f - smoothstep(1.0f - edge, 1.0f + edge, ellDist);
+        };
+
+        float coverageSum = 0.0f;
+        for (int y = minY; y <= maxY; y++) {
+            for (int x = minX; x <= maxX; x++) {
+                coverageSum += std::max(0.0f, coverageAt(x, y));
+            }
+        }
+        if (coverageSum <= 0.0f) return;
+        const float scale = alpha * area / coverageSum;
+
+        for (int y = minY; y <= maxY; y++) {
+            float* row = L.rgb.data() + (size_t)y * L.width * 3;
+            for (int x = minX; x <= maxX; x++) {
+                float coverage = coverageAt(x, y);
+                if (coverage <= 0.0f) continue;
+                float a = coverage * scale;
+                float* px = row + x * 3;
+                px[0] += a * colR;
+                px[1] += a * colG;
+                px[2] += a * colB;
+            }
+        }
+        L.dirty = true;
+    }
+
+    // Running-sum box blur along one axis (edge pixels clamped).
+    static void boxBlurPass(const float* src, float* dst, int count, int lines, size_t step, size_t lineStep, int radius) {
+        const float norm = 1.0f / (float)(2 * radius + 1);
+        for (int line = 0; line < lines; ++line) {
+            const float* s = src + line * lineStep;
+            float* d = dst + line * lineStep;
+            for (int c = 0; c < 3; ++c) {
+                float sum = s[c] * (float)(radius + 1);
+                for (int i = 1; i <= radius; ++i) {
+                    sum += s[std::min(i, count - 1) * step + c];
+                }
+                for (int i = 0; i < count; ++i) {
+                    d[i * step + c] = sum * norm;
+                    int add = std::min(i + radius + 1, count - 1);
+                    int sub = std::max(i - radius, 0);
+                    sum += s[add * step + c] - s[sub * step + c];
+                }
+            }
+        }
+    }
+
+    void blurLayer(SnowDepthLayer& L) {
+        if (L.blurRadius <= 0) return;
+        const size_t px = 3;
+        const size_t rowStride = (size_t)L.width * 3;
+        for (int pass = 0; pass < 2; ++pass) {
+            boxBlurPass(L.rgb.data(), L.scratch.data(), L.width, L.height, px, rowStride, L.blurRadius);
+            boxBlurPass(L.scratch.data(), L.rgb.data(), L.height, L.width, rowStride, px, L.blurRadius);
+        }
+    }
+
+    // Bilinearly upsample a blurred layer and add it to the frame.
+    void compositeLayer(SnowDepthLayer& L, std::vector<uint8_t>& frame) {
+        const float inv = 1.0f / (float)L.scale;
+        const size_t rowStride = (size_t)L.width * 3;
+        for (int y = 0; y < height_; ++y) {
+            float fy = std::clamp((y + 0.5f) * inv - 0.5f, 0.0f, (float)(L.height - 1));
+            int y0 = (int)fy;
+            int y1 = std::min(y0 + 1, L.height - 1);
+            float ty = fy - y0;
+            const float* r0 = L.rgb.data() + y0 * rowStride;
+            const float* r1 = L.rgb.data() + y1 * rowStride;
+            uint8_t* out = frame.data() + (size_t)y * width_ * 3;
+            for (int x = 0; x < width_; ++x) {
+                float fx = std::clamp((x + 0.5f) * inv - 0.5f, 0.0f, (float)(L.width - 1));
+                int x0 = (int)fx;
+                int x1 = std::min(x0 + 1, L.width - 1);
+                float tx = fx - x0;
+                for (int c = 0; c < 3; ++c) {
+                    float top = r0[x0 * 3 + c] + (r0[x1 * 3 + c] - r0[x0 * 3 + c]) * tx;
+                    float bot = r1[x0 * 3 + c] + (r1[x1 * 3 + c] - r1[x0 * 3 + c]) * tx;
+                    float add = top + (bot - top) * ty;
+                    if (add <= 0.002f) continue;
+                    float res = std::min(1.0f, out[x * 3 + c] / 255.0f + add);
+                    out[x * 3 + c] = (uint8_t)(255 * res);
+                }
+            }
+        }
+    }
     
 public:
     SnowflakeEffect()
         : numFlakes_(150), avgSize_(3.0f), sizeVariance_(1.5f), minSize_(0.5f), maxSize_(-1.0f), sizeBias_(2.0f),
             avgMotionX_(0.5f), avgMotionY_(2.0f), motionRandomness_(1.0f),
-            softness_(2.0f), maxBrightness_(1.0f), brightnessSpeed_(1.0f), timeoutFadeDuration_(0.8f), baseHue_(0.0f), baseSaturation_(0.0f), baseValue_(1.0f), hueRange_(0.0f), frameCount_(0), spinFraction_(0.55f), spinMinAspect_(0.1f), spinAxis_(0), shapeMode_(ShapeMode::Ellipse), colorMode_(ColorMode::Solid), rng_(std::random_device{}()) {}
+            softness_(2.0f), maxBrightness_(1.0f), brightnessSpeed_(1.0f), timeoutFadeDuration_(0.8f), baseHue_(0.0f), baseSaturation_(0.0f), baseValue_(1.0f), hueRange_(0.0f), frameCount_(0), spinFraction_(0.55f), spinMinAspect_(0.1f), spinAxis_(0), shapeMode_(ShapeMode::Ellipse), colorMode_(ColorMode::Solid), depthLayers_(0), rng_(std::random_device{}()) {}
         
     
     std::string getName() const override {
@@ -429,6 +623,7 @@ public:
         opts.push_back({"--min-size", "float", 0.01, 10.0, true, "Minimum flake size", "0.5", true});
         opts.push_back({"--max-size", "float", 0.01, 600.0, true, "Maximum flake size (default: avgSize*6)", "", true});
         opts.push_back({"--size-bias", "float", 0.0, 100.0, true, "Bias for exponential size distribution (>0). Larger => more small flakes", "2.0", true});
+        opts.push_back({"--depth-layers", "int", 0, 6, true, "Depth layers for soft snow (0=off). Flakes smaller than --size render crisp into reduced-resolution layers blurred once per layer", "0", true});
         return opts;
     }
     
@@ -559,6 +754,9 @@ public:
             sizeBias_ = std::atof(argv[++i]);
             if (sizeBias_ <= 0.0f) sizeBias_ = 1.0f;
             return true;
+        } else if (arg == "--depth-layers" && i + 1 < argc) {
+            depthLayers_ = std::clamp(std::atoi(argv[++i]), 0, 6);
+            return true;
         }
         
         return false;
@@ -571,6 +769,7 @@ public:
         if(maxSize_ < 0.0f) {
             maxSize_ = avgSize_ * 6.0f;
         }
+        setupDepthLayers();
         
         std::uniform_real_distribution<float> distX(0, width);
         std::uniform_real_distribution<float> distY(0, height);
@@ -663,14 +862,32 @@ public:
                 perFlakeFade = 1.0f - fadeProgress;
             }
 
-            if (shapeMode_ == ShapeMode::Heart) {
+            if (f.layer > 0 && f.layer < (int)layers_.size()) {
+                float alpha = std::clamp(opacity * fadeMultiplier * perFlakeFade, 0.0f, 1.0f);
+                splatToLayer(layers_[f.layer], f.x, f.y, rx, ry, alpha, f.colorR, f.colorG, f.colorB);
+            } else if (shapeMode_ == ShapeMode::Heart) {
                 drawHeart(frame, (int)f.x, (int)f.y, rx, ry, opacity, fadeMultiplier * perFlakeFade, f.colorR, f.colorG, f.colorB);
             } else {
                 drawEllipse(frame, (int)f.x, (int)f.y, rx, ry, opacity, fadeMultiplier * perFlakeFade, f.colorR, f.colorG, f.colorB);
             }
         }
+
+        // Far layers sit behind the near flakes; additive blending makes the
+        // composite order irrelevant, so blur and add each layer once.
+        for (size_t k = 1; k < layers_.size(); ++k) {
+            SnowDepthLayer& L = layers_[k];
+            if (!L.dirty) continue;
+            blurLayer(L);
+            compositeLayer(L, frame);
+            std::fill(L.rgb.begin(), L.rgb.end(), 0.0f);
+            L.dirty = false;
+        }
     }
     
+    void setSeed(uint32_t seed) override {
+        rng_.seed(seed);
+    }
+
     void update() override {
         std::normal_distribution<float> perturbVx(0, motionRandomness_ * 0.1f);
         std::normal_distribution<float> perturbVy(0, motionRandomness_ * 0.1f);
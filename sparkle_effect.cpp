@@ -482,6 +482,10 @@ public:
         }
     }
 
+    void setSeed(uint32_t seed) override {
+        rng_.seed(seed);
+    }
+
     void update() override {
         frameCount_++;
         float phaseStep = (twinkleSpeed_ * 2.0f * kPi) / std::max(1, fps_);
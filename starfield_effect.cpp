@@ -305,6 +305,15 @@ public:
         }
     }
 
+    std::unique_ptr<Effect> cloneForRender() const override {
+        // renderFrame only reads state, so a copy can render this frame.
+        return std::make_unique<StarfieldEffect>(*this);
+    }
+
+    void setSeed(uint32_t seed) override {
+        rng_.seed(seed);
+    }
+
     void update() override {
         // Move stars; recompute speed each frame so they accelerate with distance from center
         float maxLen = std::sqrt((float)width_ * width_ + (float)height_ * height_);
@@ -0,0 +1,102 @@
+// task_pool.cpp
+// Shared worker pool for the render pipeline.
+
+#include "task_pool.h"
+#include <algorithm>
+
+namespace taskpool {
+
+TaskPool::TaskPool(int threads) {
+    int n = std::max(1, threads);
+    for (int i = 0; i < n; ++i) queues_.push_back(std::make_unique<Queue>());
+    threads_.reserve((size_t)n);
+    for (int i = 0; i < n; ++i) {
+        threads_.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMu_);
+        stopping_ = true;
+    }
+    work_.notify_all();
+    for (auto& t : threads_) t.join();
+}
+
+void TaskPool::submit(int affinity, std::function<void()> task) {
+    outstanding_.fetch_add(1);
+    Queue& q = *queues_[(size_t)std::max(0, affinity) % queues_.size()];
+    {
+        std::lock_guard<std::mutex> lock(q.mu);
+        q.tasks.push_back(std::move(task));
+    }
+    {
+        // Publish under the sleep lock so a worker between checking queued_
+        // and waiting cannot miss the wake-up.
+        std::lock_guard<std::mutex> lock(sleepMu_);
+        queued_.fetch_add(1);
+    }
+    // One task needs one worker; whichever wakes takes its own queue first
+    // and otherwise steals this task.
+    work_.notify_one();
+}
+
+void TaskPool::wait() {
+    std::unique_lock<std::mutex> lock(sleepMu_);
+    idle_.wait(lock, [this] { return outstanding_.load() == 0; });
+}
+
+uint64_t TaskPool::stolen() const {
+    return stolen_.load();
+}
+
+// Both pops take the oldest task, which belongs to the earliest frame and so
+// is the one the writer will need first.
+bool TaskPool::popOwn(int index, std::function<void()>& task) {
+    Queue& q = *queues_[(size_t)index];
+    std::lock_guard<std::mutex> lock(q.mu);
+    if (q.tasks.empty()) return false;
+    task = std::move(q.tasks.front());
+    q.tasks.pop_front();
+    return true;
+}
+
+bool TaskPool::steal(int index, std::function<void()>& task) {
+    const size_t n = queues_.size();
+    for (size_t k = 1; k < n; ++k) {
+        Queue& q = *queues_[((size_t)index + k) % n];
+        std::lock_guard<std::mutex> lock(q.mu);
+        if (q.tasks.empty()) continue;
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        stolen_.fetch_add(1);
+        return true;
+    }
+    return false;
+}
+
+void TaskPool::workerLoop(int index) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(sleepMu_);
+            work_.wait(lock, [this] { return queued_.load() > 0 || stopping_; });
+            if (queued_.load() == 0) return;
+        }
+
+        // Steal only when the own queue is empty. Another worker may have
+        // taken the task this one was woken for; then go back to sleep.
+        std::function<void()> task;
+        if (!popOwn(index, task) && !steal(index, task)) continue;
+        queued_.fetch_sub(1);
+
+        task();
+
+        if (outstanding_.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(sleepMu_);
+            idle_.notify_all();
+        }
+    }
+}
+
+} // namespace taskpool
@@ -0,0 +1,67 @@
+// task_pool.h
+// Shared worker pool for the render pipeline. Each worker has its own task
+// queue with its own lock; a task is queued on the worker its affinity hint
+// names, and workers whose queue is empty steal from the others.
+
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace taskpool {
+
+class TaskPool {
+public:
+    explicit TaskPool(int threads);
+    // Runs every queued task before the workers exit.
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    int size() const { return (int)threads_.size(); }
+
+    // Queue `task` on worker `affinity % size()`. Tasks must not block on
+    // other tasks.
+    void submit(int affinity, std::function<void()> task);
+
+    // Block until no task is queued or running.
+    void wait();
+
+    // Tasks run by a worker other than the one they were queued on.
+    uint64_t stolen() const;
+
+private:
+    struct Queue {
+        std::mutex mu;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void workerLoop(int index);
+    bool popOwn(int index, std::function<void()>& task);
+    bool steal(int index, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    // Tasks sitting in queues, and tasks queued or running.
+    std::atomic<size_t> queued_{0};
+    std::atomic<size_t> outstanding_{0};
+    std::atomic<uint64_t> stolen_{0};
+    // Only for sleeping and waking; the queues have their own locks.
+    std::mutex sleepMu_;
+    std::condition_variable work_;
+    std::condition_variable idle_;
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+};
+
+} // namespace taskpool
+
+#endif // TASK_POOL_H
@@ -748,6 +748,24 @@ public:
         }
     }
 
+    // Stars are drawn every frame; with tracking each star is also matched
+    // against the detected hotspots (at most --hotspots of them).
+    CostModel costModel() const override {
+        CostModel model;
+        model.unit = "star-matches";
+        model.current = numStars_;
+        model.steady = numStars_;
+        if (trackBrightSpots_) {
+            model.current += (double)numStars_ * prevHotspots_.size();
+            model.steady += (double)numStars_ * maxHotspots_;
+        }
+        return model;
+    }
+
+    void setSeed(uint32_t seed) override {
+        rng_.seed(seed);
+    }
+
     void update() override {
         float dt = (fps_ > 0) ? (1.0f / (float)fps_) : 0.0333f;
         frameCount_++;
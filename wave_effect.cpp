@@ -28,6 +28,20 @@ struct WaveSource {
     int rampDownFrames;   // Frames to ramp down to zero
 };
 
+// Per-frame radial profile of one source: its contribution sampled over the
+// distance range that reaches the frame, so pixels only need a lookup.
+struct WaveProfile {
+    float x, y;           // Source position
+    float r0;             // Distance of the first table entry
+    float invStep;        // Table entries per pixel of distance
+    bool direct;          // Table would be too large; evaluate sin directly
+    float amplitude;      // Only used when direct
+    float waveNumber;
+    float phase;
+    float decay;
+    std::vector<float> values;
+};
+
 // Recorded spawn specification used for warmup recording/replay
 struct SpawnSpec {
     float x, y;
@@ -87,6 +101,10 @@ private:
     std::mt19937 rng_;
     int frameCount_;
 
+    // Radial lookup tables rebuilt once per rendered frame
+    std::vector<WaveProfile> profiles_;
+    std::vector<float> waveRow_;
+
     void collectSourceStats(int& activeCount, float& sumStrength) const {
         activeCount = 0;
         sumStrength = 0.0f;
@@ -387,6 +405,80 @@ private:
         return totalHeight;
     }
     
+    // Build one radial table per active source covering [min, max] distance
+    // from the source to the frame. Samples are spaced at most half a pixel
+    // apart and at least 64 per wavelength, so linear interpolation stays
+    // well below one 8-bit step.
+    void buildWaveProfiles() {
+        const size_t kMaxTableEntries = 1 << 20;
+        size_t count = 0;
+        for (const auto& ws : sources_) {
+            if (!ws.active) continue;
+            if (profiles_.size() <= count) profiles_.emplace_back();
+            WaveProfile& p = profiles_[count++];
+
+            float nearX = std::clamp(ws.x, 0.0f, (float)(width_ - 1));
+            float nearY = std::clamp(ws.y, 0.0f, (float)(height_ - 1));
+            float farX = std::max(std::abs(ws.x), std::abs(ws.x - (width_ - 1)));
+            float farY = std::max(std::abs(ws.y), std::abs(ws.y - (height_ - 1)));
+            float rMin = std::sqrt((ws.x - nearX) * (ws.x - nearX) + (ws.y - nearY) * (ws.y - nearY));
+            float rMax = std::sqrt(farX * farX + farY * farY);
+
+            float wavelength = 2.0f * kPi / std::max(0.0001f, std::abs(ws.frequency));
+            float step = std::min(0.5f, wavelength / 64.0f);
+            size_t entries = (size_t)std::ceil((rMax - rMin) / step) + 2;
+
+            p.x = ws.x;
+            p.y = ws.y;
+            p.r0 = rMin;
+            p.invStep = 1.0f / step;
+            p.amplitude = ws.amplitude * ws.currentStrength;
+            p.waveNumber = ws.frequency;
+            p.phase = ws.phase;
+            p.decay = ws.decay;
+            p.direct = entries > kMaxTableEntries;
+            if (p.direct) {
+                p.values.clear();
+                continue;
+            }
+            p.values.resize(entries);
+            for (size_t i = 0; i < entries; ++i) {
+                float r = rMin + (float)i * step;
+                p.values[i] = p.amplitude * std::sin(p.waveNumber * r - p.phase) / (1.0f + p.decay * r);
+            }
+        }
+        profiles_.resize(count);
+    }
+
+    // Sum all source profiles for one row into waveRow_. Must be preceded by
+    // buildWaveProfiles() for the current frame.
+    void computeWaveRow(int y) {
+        float* out = waveRow_.data();
+        std::fill(waveRow_.begin(), waveRow_.end(), 0.0f);
+        for (const auto& p : profiles_) {
+            float dy = (float)y - p.y;
+            float dy2 = dy * dy;
+            if (p.direct) {
+                for (int x = 0; x < width_; x++) {
+                    float dx = (float)x - p.x;
+                    float r = std::sqrt(dx * dx + dy2);
+                    out[x] += p.amplitude * std::sin(p.waveNumber * r - p.phase) / (1.0f + p.decay * r);
+                }
+                continue;
+            }
+            const float* table = p.values.data();
+            const int last = (int)p.values.size() - 2;
+            for (int x = 0; x < width_; x++) {
+                float dx = (float)x - p.x;
+                float t = (std::sqrt(dx * dx + dy2) - p.r0) * p.invStep;
+                t = std::clamp(t, 0.0f, (float)last);
+                int i = (int)t;
+                float f = t - (float)i;
+                out[x] += table[i] + (table[i + 1] - table[i]) * f;
+            }
+        }
+    }
+    
     float calculateDirectionalLight(float x, float y, float waveHeight) {
         // Calculate normal vector from wave height gradient (simplified)
         // In reality we'd compute gradient, but for performance we'll use the wave height directly
@@ -648,6 +740,12 @@ public:
     void setGlobalWarmupSeconds(float seconds) override {
         globalWarmupSeconds_ = std::max(0.0f, seconds);
     }
+
+    // Any warmup turns on the loop replay, which needs the spawns recorded
+    // before the timeline's first frame.
+    bool supportsFrameRange() const override {
+        return warmupSeconds_ <= 0.0f && globalWarmupSeconds_ <= 0.0f;
+    }
     
     // Bilinear interpolation for smooth sampling
     void samplePixel(const std::vector<uint8_t>& sourceFrame, float x, float y, uint8_t* rgb) {
@@ -684,13 +782,68 @@ public:
         }
     }
     
-    void renderFrame(std::vector<uint8_t>& frame, bool hasBackground, float fadeMultiplier) override {
+    void beginRender() {
         logLoopFrameState("render", frameCount_);
+        buildWaveProfiles();
+        waveRow_.resize(width_);
+    }
+
+    // Displacement mode: distort `source` into `frame` AND apply brightness modulation
+    void renderDisplaced(const std::vector<uint8_t>& source, std::vector<uint8_t>& frame, float fadeMultiplier) {
+        for (int y = 0; y < height_; y++) {
+            computeWaveRow(y);
+            for (int x = 0; x < width_; x++) {
+                float waveHeight = waveRow_[x];
+                
+                // Displacement direction: lower-right for positive waves, upper-left for negative
+                // This creates the "refraction" effect
+                float displacementX = waveHeight * displacementScale_;
+                float displacementY = waveHeight * displacementScale_;
+                
+                // Sample from the displaced position
+                float sourceX = x - displacementX;
+                float sourceY = y - displacementY;
+                
+                int idx = (y * width_ + x) * 3;
+                uint8_t rgb[3];
+                samplePixel(source, sourceX, sourceY, rgb);
+                
+                // Calculate brightness modulation based on directional lighting
+                float lightMod = calculateDirectionalLight(x, y, waveHeight);
+                float brightnessMod = 1.0f + lightMod;
+                brightnessMod = std::clamp(brightnessMod, 0.5f, 1.5f);
+                brightnessMod *= fadeMultiplier;
+                
+                // Apply both displacement AND brightness modulation
+                for (int c = 0; c < 3; c++) {
+                    float modulated = (rgb[c] / 255.0f) * brightnessMod;
+                    frame[idx + c] = (uint8_t)(std::clamp(modulated, 0.0f, 1.0f) * 255);
+                }
+            }
+        }
+    }
+
+    // Displacement replaces every pixel, so sample straight from the shared
+    // input into a fresh frame rather than copying the input first.
+    void renderFrameBuffer(FrameBuffer& frame, bool hasBackground, float fadeMultiplier) override {
+        if (!hasBackground || !useDisplacement_) {
+            renderFrame(frame.write(), hasBackground, fadeMultiplier);
+            return;
+        }
+        beginRender();
+        std::vector<uint8_t> displaced(frame.size());
+        renderDisplaced(frame.read(), displaced, fadeMultiplier);
+        frame = FrameBuffer(std::move(displaced));
+    }
+
+    void renderFrame(std::vector<uint8_t>& frame, bool hasBackground, float fadeMultiplier) override {
+        beginRender();
         if (!hasBackground) {
             // Without background, just show the waves as grayscale
             for (int y = 0; y < height_; y++) {
+                computeWaveRow(y);
                 for (int x = 0; x < width_; x++) {
-                    float waveHeight = calculateWaveHeight(x, y);
+                    float waveHeight = waveRow_[x];
                     
                     // Map wave height to brightness
                     float brightness = 0.5f + waveHeight;
@@ -705,45 +858,15 @@ public:
                 }
             }
         } else if (useDisplacement_) {
-            // Displacement mode: distort the image AND apply brightness modulation
             // Make a copy of the current frame to sample from
             std::vector<uint8_t> originalFrame = frame;
-            
-            for (int y = 0; y < height_; y++) {
-                for (int x = 0; x < width_; x++) {
-                    float waveHeight = calculateWaveHeight(x, y);
-                    
-                    // Displacement direction: lower-right for positive waves, upper-left for negative
-                    // This creates the "refraction" effect
-                    float displacementX = waveHeight * displacementScale_;
-                    float displacementY = waveHeight * displacementScale_;
-                    
-                    // Sample from the displaced position
-                    float sourceX = x - displacementX;
-                    float sourceY = y - displacementY;
-                    
-                    int idx = (y * width_ + x) * 3;
-                    uint8_t rgb[3];
-                    samplePixel(originalFrame, sourceX, sourceY, rgb);
-                    
-                    // Calculate brightness modulation based on directional lighting
-                    float lightMod = calculateDirectionalLight(x, y, waveHeight);
-                    float brightnessMod = 1.0f + lightMod;
-                    brightnessMod = std::clamp(brightnessMod, 0.5f, 1.5f);
-                    brightnessMod *= fadeMultiplier;
-                    
-                    // Apply both displacement AND brightness modulation
-                    for (int c = 0; c < 3; c++) {
-                        float modulated = (rgb[c] / 255.0f) * brightnessMod;
-                        frame[idx + c] = (uint8_t)(std::clamp(modulated, 0.0f, 1.0f) * 255);
-                    }
-                }
-            }
+            renderDisplaced(originalFrame, frame, fadeMultiplier);
         } else {
             // Brightness modulation only mode (original behavior)
             for (int y = 0; y < height_; y++) {
+                computeWaveRow(y);
                 for (int x = 0; x < width_; x++) {
-                    float waveHeight = calculateWaveHeight(x, y);
+                    float waveHeight = waveRow_[x];
                     float lightMod = calculateDirectionalLight(x, y, waveHeight);
                     
                     // Apply lighting modulation
@@ -763,6 +886,24 @@ public:
         }
     }
     
+    // Every pixel sums every active source. Sources spawn with
+    // sourceSpawnProb_ per frame and live (min+max)/2 seconds on average.
+    CostModel costModel() const override {
+        CostModel model;
+        model.unit = "pixel-sources";
+        int active = 0;
+        float strength = 0.0f;
+        collectSourceStats(active, strength);
+        double pixels = (double)width_ * height_;
+        model.current = pixels * active;
+        model.steady = pixels * sourceSpawnProb_ * 0.5 * (minLifetime_ + maxLifetime_) * fps_;
+        return model;
+    }
+
+    void setSeed(uint32_t seed) override {
+        rng_.seed(seed);
+    }
+
     void update() override {
         // Consume global warmup update ticks without mutating simulation state.
         if (frameCount_ < 0) {